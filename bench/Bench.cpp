@@ -0,0 +1,445 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#include <cstdint>
+#include "Solver.h"
+#include "Cell.h"
+#include "FF.h"
+#include "Pin.h"
+#include "Bin.h"
+#include "Site.h"
+#include "LegalPlacer.h"
+#include "ThreadConfig.h"
+
+/*
+Micro-benchmarks of the incremental timing and placement kernels on a parsed and initially placed case.
+Every kernel is run in trial mode so the state is the same for all of them, and reports ns/op and allocations/op.
+With --scaling the whole flow is run at 1, 2, 4 ... threads instead and the speedup of each phase is reported.
+Cases can be made with bin/GEN.
+*/
+
+// every operator new of the process is counted
+static std::atomic<long long> allocCount(0);
+// called through a pointer so the compiler does not pair it with the operator new of the callers
+static void (*volatile releaseMemory)(void*) = std::free;
+
+void* operator new(std::size_t size)
+{
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    void* p = std::malloc(size ? size : 1);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    releaseMemory(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    releaseMemory(p);
+}
+
+// results are summed here so the kernels are not optimized away
+static volatile double benchSink = 0;
+
+class SolverBench
+{
+    public:
+        SolverBench(Solver* solver, double minTime, const std::string& filter, unsigned seed);
+
+        void run();
+        // solve the case at 1, 2, 4 ... maxThreads threads and print the time and speedup of each phase
+        static void scaling(const std::string& input, int maxThreads);
+    private:
+        Solver* _solver;
+        double _minTime;
+        std::string _filter;
+        std::mt19937 _rng;
+
+        template <typename F>
+        void measure(const std::string& name, size_t numInputs, F op);
+
+        void benchCalSlack();
+        void benchCalCostMoveFF();
+        void benchCalCostBankFF();
+        void benchBinMoveCell();
+        void benchPlaceable();
+        void benchNearestSite();
+        void benchSitesInBlock();
+        void benchPlaceRow();
+};
+
+SolverBench::SolverBench(Solver* solver, double minTime, const std::string& filter, unsigned seed)
+{
+    _solver = solver;
+    _minTime = minTime;
+    _filter = filter;
+    _rng.seed(seed);
+}
+
+/*
+Run op(i) for i = 0, 1, ... over the inputs until minTime has passed, doubling the batch size
+*/
+template <typename F>
+void SolverBench::measure(const std::string& name, size_t numInputs, F op)
+{
+    if (numInputs == 0 || name.find(_filter) == std::string::npos)
+    {
+        return;
+    }
+    // warm up
+    for (size_t i = 0; i < std::min<size_t>(numInputs, 1024); i++)
+    {
+        benchSink = benchSink + op(i);
+    }
+    size_t batch = 64;
+    size_t ops = 0;
+    long long allocs = 0;
+    double elapsed = 0;
+    while (elapsed < _minTime)
+    {
+        const long long allocStart = allocCount.load();
+        auto start = std::chrono::steady_clock::now();
+        double sum = 0;
+        for (size_t i = 0; i < batch; i++)
+        {
+            sum += op((ops + i) % numInputs);
+        }
+        std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+        allocs += allocCount.load() - allocStart;
+        benchSink = benchSink + sum;
+        elapsed += d.count();
+        ops += batch;
+        batch *= 2;
+    }
+    std::cout << std::setw(28) << std::left << name << std::right
+              << std::setw(12) << ops
+              << std::setw(14) << std::fixed << std::setprecision(1) << elapsed * 1e9 / ops
+              << std::setw(14) << std::setprecision(2) << double(allocs) / ops << std::endl;
+}
+
+void SolverBench::run()
+{
+    std::cout << std::setw(28) << std::left << "benchmark" << std::right << std::setw(12) << "ops"
+              << std::setw(14) << "ns/op" << std::setw(14) << "allocs/op" << std::endl;
+    benchCalSlack();
+    benchCalCostMoveFF();
+    benchCalCostBankFF();
+    benchBinMoveCell();
+    benchPlaceable();
+    benchNearestSite();
+    benchSitesInBlock();
+    benchPlaceRow();
+}
+
+/*
+Pin::calSlack of D pins grouped by their number of paths, moving one previous stage pin
+*/
+void SolverBench::benchCalSlack()
+{
+    const size_t bounds[] = {1, 8, 64, SIZE_MAX};
+    const char* names[] = {"calSlack/paths=1", "calSlack/paths=2-8", "calSlack/paths=9-64", "calSlack/paths>64"};
+    std::vector<std::vector<Pin*>> buckets(4);
+    for (auto ff : _solver->_ffs)
+    {
+        for (auto inPin : ff->getInputPins())
+        {
+            const size_t numPaths = inPin->getPrevStagePinsSize();
+            if (numPaths == 0)
+                continue;
+            size_t b = 0;
+            while (numPaths > bounds[b])
+            {
+                b++;
+            }
+            buckets[b].push_back(inPin);
+        }
+    }
+    for (size_t b = 0; b < buckets.size(); b++)
+    {
+        std::vector<Pin*>& pins = buckets[b];
+        std::shuffle(pins.begin(), pins.end(), _rng);
+        measure(names[b], pins.size(), [&pins](size_t i) {
+            Pin* pin = pins[i];
+            Pin* prevPin = pin->getPrevStagePins()[i % pin->getPrevStagePinsSize()];
+            const int x = prevPin->getGlobalX();
+            const int y = prevPin->getGlobalY();
+            return pin->calSlack(prevPin, x, y, x + 500, y - 300, false);
+        });
+    }
+}
+
+void SolverBench::benchCalCostMoveFF()
+{
+    std::vector<FF*> ffs = _solver->_ffs;
+    std::shuffle(ffs.begin(), ffs.end(), _rng);
+    Solver* solver = _solver;
+    measure("calCostMoveFF", ffs.size(), [solver, &ffs](size_t i) {
+        FF* ff = ffs[i];
+        return solver->calCostMoveFF(ff, ff->getX(), ff->getY(), ff->getX() + 500, ff->getY() - 300, false);
+    });
+}
+
+/*
+calCostBankFF of each FF with the next FF of its clock domain into the best lib cell of their bits
+*/
+void SolverBench::benchCalCostBankFF()
+{
+    struct BankInput { FF* ff1; FF* ff2; LibCell* lib; };
+    std::vector<BankInput> inputs;
+    for (auto& domain : _solver->_ffs_clkdomains)
+    {
+        for (size_t i = 0; i + 1 < domain.size(); i += 2)
+        {
+            const int bit = domain[i]->getBit() + domain[i + 1]->getBit();
+            auto it = _solver->_bestCostPAFFs.find(bit);
+            if (it != _solver->_bestCostPAFFs.end() && it->second != nullptr)
+            {
+                inputs.push_back(BankInput{domain[i], domain[i + 1], it->second});
+            }
+        }
+    }
+    std::shuffle(inputs.begin(), inputs.end(), _rng);
+    Solver* solver = _solver;
+    measure("calCostBankFF", inputs.size(), [solver, &inputs](size_t i) {
+        const BankInput& in = inputs[i];
+        return solver->calCostBankFF(in.ff1, in.ff2, in.lib, in.ff1->getX(), in.ff1->getY(), false);
+    });
+}
+
+void SolverBench::benchBinMoveCell()
+{
+    std::vector<FF*> ffs = _solver->_ffs;
+    std::shuffle(ffs.begin(), ffs.end(), _rng);
+    BinMap* binMap = _solver->_binMap;
+    measure("BinMap::moveCell", ffs.size(), [binMap, &ffs](size_t i) {
+        FF* ff = ffs[i];
+        const int x = std::min(ff->getX() + BIN_WIDTH / 2, DIE_UP_RIGHT_X - ff->getWidth());
+        const int y = std::min(ff->getY() + BIN_HEIGHT / 2, DIE_UP_RIGHT_Y - ff->getHeight());
+        return binMap->moveCell(ff, x, y, true);
+    });
+}
+
+/*
+placeable at the nearest site of a random point near each FF
+*/
+void SolverBench::benchPlaceable()
+{
+    std::vector<std::pair<FF*, Site*>> inputs;
+    std::uniform_int_distribution<int> offset(-2 * BIN_WIDTH, 2 * BIN_WIDTH);
+    for (auto ff : _solver->_ffs)
+    {
+        const int x = std::min(std::max(ff->getX() + offset(_rng), DIE_LOW_LEFT_X), DIE_UP_RIGHT_X - 1);
+        const int y = std::min(std::max(ff->getY() + offset(_rng), DIE_LOW_LEFT_Y), DIE_UP_RIGHT_Y - 1);
+        Site* site = _solver->_siteMap->getNearestSite(x, y);
+        if (site != nullptr)
+        {
+            inputs.push_back(std::make_pair(ff, site));
+        }
+    }
+    std::shuffle(inputs.begin(), inputs.end(), _rng);
+    Solver* solver = _solver;
+    measure("Solver::placeable", inputs.size(), [solver, &inputs](size_t i) {
+        return solver->placeable(inputs[i].first, inputs[i].second->getX(), inputs[i].second->getY()) ? 1.0 : 0.0;
+    });
+}
+
+void SolverBench::benchNearestSite()
+{
+    std::vector<std::pair<int, int>> points(1 << 16);
+    std::uniform_int_distribution<int> px(DIE_LOW_LEFT_X, DIE_UP_RIGHT_X - 1);
+    std::uniform_int_distribution<int> py(DIE_LOW_LEFT_Y, DIE_UP_RIGHT_Y - 1);
+    for (auto& p : points)
+    {
+        p = std::make_pair(px(_rng), py(_rng));
+    }
+    SiteMap* siteMap = _solver->_siteMap;
+    measure("SiteMap::getNearestSite", points.size(), [siteMap, &points](size_t i) {
+        Site* site = siteMap->getNearestSite(points[i].first, points[i].second);
+        return (site != nullptr) ? double(site->getX()) : 0.0;
+    });
+}
+
+/*
+getSitesInBlock of a bin-sized block at random points
+*/
+void SolverBench::benchSitesInBlock()
+{
+    std::vector<std::pair<int, int>> points(1 << 12);
+    std::uniform_int_distribution<int> px(DIE_LOW_LEFT_X, std::max(DIE_LOW_LEFT_X, DIE_UP_RIGHT_X - BIN_WIDTH));
+    std::uniform_int_distribution<int> py(DIE_LOW_LEFT_Y, std::max(DIE_LOW_LEFT_Y, DIE_UP_RIGHT_Y - BIN_HEIGHT));
+    for (auto& p : points)
+    {
+        p = std::make_pair(px(_rng), py(_rng));
+    }
+    SiteMap* siteMap = _solver->_siteMap;
+    measure("SiteMap::getSitesInBlock", points.size(), [siteMap, &points](size_t i) {
+        const int x = points[i].first;
+        const int y = points[i].second;
+        return double(siteMap->getSitesInBlock(x, y, x + BIN_WIDTH, y + BIN_HEIGHT).size());
+    });
+}
+
+/*
+LegalPlacer::placeRow in trial mode on the sub row nearest to each FF
+*/
+void SolverBench::benchPlaceRow()
+{
+    LegalPlacer* legalizer = _solver->_legalizer;
+    std::vector<std::pair<FF*, int>> inputs;
+    std::vector<FF*> ffs = _solver->_ffs;
+    std::shuffle(ffs.begin(), ffs.end(), _rng);
+    for (size_t i = 0; i < ffs.size() && inputs.size() < 256; i++)
+    {
+        std::vector<int> nearSubRows = legalizer->getNearSubRows(ffs[i], -1, 2 * (BIN_WIDTH + BIN_HEIGHT));
+        if (!nearSubRows.empty())
+        {
+            inputs.push_back(std::make_pair(ffs[i], nearSubRows[i % nearSubRows.size()]));
+        }
+    }
+    measure("LegalPlacer::placeRow", inputs.size(), [legalizer, &inputs](size_t i) {
+        return legalizer->placeRow(inputs[i].first, inputs[i].second, true);
+    });
+}
+
+/*
+Every run parses and solves the case in a fresh solver with the output of the solver silenced,
+the phases are matched by name so a phase missing from a run is shown as -
+*/
+void SolverBench::scaling(const std::string& input, int maxThreads)
+{
+    std::vector<int> threadCounts;
+    for (int t = 1; t < maxThreads; t *= 2)
+    {
+        threadCounts.push_back(t);
+    }
+    threadCounts.push_back(maxThreads);
+
+    std::vector<std::vector<PhaseStats>> runs;
+    std::vector<double> totals;
+    for (int t : threadCounts)
+    {
+        ThreadConfig::setThreads(t);
+        std::cerr << "Solving with " << t << " threads..." << std::endl;
+        std::streambuf* coutBuf = std::cout.rdbuf(nullptr);
+        auto start = std::chrono::steady_clock::now();
+        Solver* solver = new Solver();
+        solver->parse_input(input);
+        solver->solve();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout.rdbuf(coutBuf);
+        runs.push_back(solver->_phaseStats);
+        totals.push_back(elapsed.count());
+        delete solver;
+    }
+
+    std::cout << std::left << std::setw(24) << "phase" << std::right;
+    for (int t : threadCounts)
+    {
+        std::cout << std::setw(12) << (std::to_string(t) + "T time") << std::setw(9) << "speedup";
+    }
+    std::cout << "\n" << std::fixed;
+    auto printRow = [&](const std::string& name, const std::vector<double>& times) {
+        std::cout << std::left << std::setw(24) << name << std::right;
+        for (size_t i = 0; i < times.size(); i++)
+        {
+            if (times[i] < 0)
+            {
+                std::cout << std::setw(12) << "-" << std::setw(9) << "-";
+                continue;
+            }
+            std::cout << std::setw(11) << std::setprecision(3) << times[i] << "s";
+            if (times[0] > 0 && times[i] > 0)
+            {
+                std::cout << std::setw(8) << std::setprecision(2) << times[0] / times[i] << "x";
+            }
+            else
+            {
+                std::cout << std::setw(9) << "-";
+            }
+        }
+        std::cout << "\n";
+    };
+    for (const PhaseStats& phase : runs[0])
+    {
+        std::vector<double> times;
+        for (const std::vector<PhaseStats>& run : runs)
+        {
+            double time = -1;
+            for (const PhaseStats& stats : run)
+            {
+                if (stats.name == phase.name)
+                {
+                    time = stats.wallTime;
+                    break;
+                }
+            }
+            times.push_back(time);
+        }
+        printRow(phase.name, times);
+    }
+    printRow("total", totals);
+    std::cout << std::defaultfloat;
+}
+
+int main(int argc, char* argv[])
+{
+    // format ./$binary_name <input.txt> [--min-time <seconds>] [--filter <substring>] [--seed <n>] [--scaling <max threads>]
+    std::string input;
+    double minTime = 0.2;
+    std::string filter;
+    unsigned seed = 1;
+    int maxThreads = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--min-time" && i + 1 < argc)
+        {
+            minTime = std::atof(argv[++i]);
+        }
+        else if (arg == "--filter" && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else if (arg == "--seed" && i + 1 < argc)
+        {
+            seed = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--scaling" && i + 1 < argc)
+        {
+            maxThreads = std::atoi(argv[++i]);
+        }
+        else
+        {
+            input = arg;
+        }
+    }
+    if (input.empty())
+    {
+        std::cerr << "Usage: " << argv[0] << " <input.txt> [--min-time <seconds>] [--filter <substring>] [--seed <n>] [--scaling <max threads>]" << std::endl;
+        return 1;
+    }
+    if (maxThreads > 0)
+    {
+        SolverBench::scaling(input, maxThreads);
+        return 0;
+    }
+    Solver* solver = new Solver();
+    solver->parse_input(input);
+    solver->init_placement();
+    SolverBench bench(solver, minTime, filter, seed);
+    bench.run();
+    delete solver;
+    return 0;
+}
@@ -1,9 +1,11 @@
 #pragma once
 #include <string>
 #include <algorithm>
+#include <unordered_map>
 #include "Bin.h"
 #include "Site.h"
 #include "Pin.h"
+#include "NameTable.h"
 
 class Site;
 class Pin;
@@ -29,6 +31,8 @@ struct LibCell
     std::vector<Pin*> outputPins;
     Pin* clkPin;
     double costPA;
+    // position of each pin name in the pins of an instance (inputs, outputs, clk)
+    std::unordered_map<NameId, size_t> pinIndex;
 
     LibCell()
     {
@@ -51,6 +55,8 @@ struct LibCell
         this->cell_name = cell_name;
     }
     ~LibCell();
+
+    void indexPins();
 };
 
 class Cell
@@ -59,6 +65,7 @@ public:
     Cell();
     // constructor for instance cells
     Cell(int x, int y, std::string inst_name, LibCell* lib_cell);
+    Cell(int x, int y, NameId inst_name, LibCell* lib_cell);
     ~Cell();
 
     inline int getX() const { return _x; }
@@ -66,18 +73,20 @@ public:
     inline int getWidth() const { return _lib_cell->width; }
     inline int getHeight() const { return _lib_cell->height; }
     inline int getArea() const { return _lib_cell->width * _lib_cell->height; }
-    inline std::string getInstName() const { return _inst_name; }
+    inline const std::string& getInstName() const { return NameTable::name(_inst_name); }
+    inline NameId getInstNameId() const { return _inst_name; }
     inline std::string getCellName() const { return _lib_cell->cell_name; }
     inline CellType getCellType() const { return _lib_cell->type; }
-    inline std::vector<Pin*> getPins() const { return _pins; }
-    inline std::vector<Pin*> getInputPins() const { return _inputPins; }
-    inline std::vector<Pin*> getOutputPins() const { return _outputPins; }
+    inline const std::vector<Pin*>& getPins() const { return _pins; }
+    inline const std::vector<Pin*>& getInputPins() const { return _inputPins; }
+    inline const std::vector<Pin*>& getOutputPins() const { return _outputPins; }
     inline double getQDelay() const { return _lib_cell->qDelay; }
     inline LibCell* getLibCell() const { return _lib_cell; }
-    Pin* getPin(std::string pin_name);
+    Pin* getPin(const std::string& pin_name);
 
     void setXY(int x, int y);
-    void setInstName(std::string inst_name);
+    void setInstName(const std::string& inst_name);
+    inline void setInstName(NameId inst_name) { _inst_name = inst_name; }
     void addPin(Pin* pin);
 
     void deletePins();
@@ -86,7 +95,7 @@ protected:
     LibCell* _lib_cell;
     int _x;
     int _y;
-    std::string _inst_name;
+    NameId _inst_name;
     std::vector<Pin*> _pins;
     std::vector<Pin*> _inputPins;
     std::vector<Pin*> _outputPins;
@@ -8,4 +8,8 @@ class Comb : public Cell
     public:
         using Cell::Cell;
         ~Comb();
+
+        // allocated from a pool of the class
+        static void* operator new(std::size_t size);
+        static void operator delete(void* p, std::size_t size);
 };
\ No newline at end of file
@@ -0,0 +1,132 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+/*
+Result of evaluating one placement, the cost components are re-derived from scratch
+*/
+struct EvalResult
+{
+    double tns = 0;
+    double power = 0;
+    double area = 0;
+    int bins = 0;
+    double cost = 0;
+    size_t numInsts = 0;
+    // errors in the output format and the pin mapping
+    int mappingErrors = 0;
+    // cells off site, out of the die or overlapping
+    int placementErrors = 0;
+
+    inline bool ok() const { return mappingErrors == 0 && placementErrors == 0; }
+};
+
+/*
+In-process evaluator of an output file against its input file.
+It has its own parser and data so it shares no state with the solver, the timing is a longest-path
+propagation over the combinational netlist, levelized and evaluated level by level in parallel.
+Load the input once, then evaluate as many outputs as needed.
+*/
+class Evaluator
+{
+    public:
+        Evaluator();
+        ~Evaluator();
+
+        bool loadInput(const std::string& filename);
+        bool evaluate(const std::string& filename, EvalResult& result);
+        bool evaluate(std::istream& in, EvalResult& result);
+        // errors found while evaluating are printed, up to this many per evaluation
+        inline void setMaxMessages(int n) { _maxMessages = n; }
+        void print(const EvalResult& result, std::ostream& out) const;
+    private:
+        enum NodeType { NODE_INPUT, NODE_OUTPUT, NODE_FF_D, NODE_FF_Q, NODE_FF_CLK, NODE_GATE_IN, NODE_GATE_OUT };
+        struct LibPin
+        {
+            std::string name;
+            NodeType type;
+            int x;
+            int y;
+        };
+        struct Lib
+        {
+            std::string name;
+            bool ff;
+            int bits;
+            int width;
+            int height;
+            double qDelay;
+            double power;
+            std::vector<LibPin> pins;
+            std::unordered_map<std::string, int> pinIndex;
+        };
+        struct Inst
+        {
+            std::string name;
+            int lib;
+            int x;
+            int y;
+            // first timing node of the instance, pins are numbered as in the library
+            int nodeBase;
+        };
+        struct Row
+        {
+            int startX;
+            int startY;
+            int siteWidth;
+            int siteHeight;
+            int numSites;
+        };
+
+        // cost metrics and design
+        double _alpha;
+        double _beta;
+        double _gamma;
+        double _lambda;
+        int _dieLowLeftX;
+        int _dieLowLeftY;
+        int _dieUpRightX;
+        int _dieUpRightY;
+        int _binWidth;
+        int _binHeight;
+        double _binMaxUtil;
+        double _dispDelay;
+        std::vector<Lib> _libs;
+        std::unordered_map<std::string, int> _libIndex;
+        std::vector<Inst> _ffs;
+        std::vector<Inst> _gates;
+        std::unordered_map<std::string, int> _ffIndex;
+        std::unordered_map<std::string, int> _gateIndex;
+        std::vector<Row> _rows;
+        // rows by their y
+        std::unordered_map<int, std::vector<int>> _rowsAtY;
+
+        // timing graph, a node per port and per pin of the instances
+        std::vector<NodeType> _nodeType;
+        std::vector<int> _nodeX;
+        std::vector<int> _nodeY;
+        std::vector<int> _nodeDriver;
+        // owner of a pin node: index in _ffs or _gates, -1 for the ports
+        std::vector<int> _nodeInst;
+        std::unordered_map<std::string, int> _portIndex;
+        // clock net of each input FF, the net index of its CLK pin
+        std::vector<int> _ffClkNet;
+        std::vector<double> _initSlack;
+        std::vector<double> _initArrival;
+        // D pins of the input FFs
+        std::vector<int> _dNodes;
+        // gates by level, the inputs of a gate are driven only by gates of the levels before it
+        std::vector<std::vector<int>> _levels;
+        int _maxMessages;
+
+        int findNode(const std::string& pinName) const;
+        void addInst(std::vector<Inst>& insts, std::unordered_map<std::string, int>& index, const std::string& name, int lib, int x, int y);
+        void levelize();
+        void propagate(const std::vector<int>& x, const std::vector<int>& y, const std::vector<double>& qDelay, std::vector<double>& arrival) const;
+        double dArrival(int node, const std::vector<int>& x, const std::vector<int>& y, const std::vector<double>& arrival) const;
+        int countBins(const std::vector<Inst>& insts) const;
+        int checkPlacement(const std::vector<Inst>& insts, int& messages) const;
+        bool onSite(int x, int y) const;
+};
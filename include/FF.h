@@ -12,6 +12,10 @@ class FF : public Cell
         FF(int x, int y, std::string inst_name, LibCell* lib_cell, std::vector<std::pair<Pin*, Pin*>> dqpairs, std::vector<Pin*> clks);
         ~FF();
 
+        // allocated from a pool of the class
+        static void* operator new(std::size_t size);
+        static void operator delete(void* p, std::size_t size);
+
         inline int getBit() const { return _lib_cell->bit; }
         inline double getQDelay() const { return _lib_cell->qDelay; }
         inline double getPower() const { return _lib_cell->power; }
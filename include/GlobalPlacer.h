@@ -0,0 +1,68 @@
+#pragma once
+#include <iostream>
+#include <vector>
+#include <unordered_map>
+
+class Solver;
+class Cell;
+class FF;
+
+/*
+Two-pin connection of an FF pin to its fanin or to the next stage, j == -1 if the other end is a fixed pin.
+slack and length are taken before the placement, the slack changes with the length by DISP_DELAY.
+*/
+struct GPConnection
+{
+    int i;
+    int offXi;
+    int offYi;
+    int j;
+    int offXj;
+    int offYj;
+    int fixedX;
+    int fixedY;
+    double slack;
+    double length;
+};
+
+/*
+Compressed sparse row matrix
+*/
+struct CSRMatrix
+{
+    std::vector<int> rowStart;
+    std::vector<int> cols;
+    std::vector<double> vals;
+    std::vector<double> diag;
+};
+
+class GlobalPlacer
+{
+    private:
+        Solver* _solver;
+        std::vector<FF*> _ffs;
+        std::unordered_map<Cell*, int> _ffIndex;
+        std::vector<GPConnection> _connections;
+        // continuous positions and anchors of the FFs
+        std::vector<double> _x;
+        std::vector<double> _y;
+        std::vector<double> _anchorX;
+        std::vector<double> _anchorY;
+        std::vector<double> _anchorWeight;
+        // utilization of the combs in each bin
+        std::vector<double> _combArea;
+        int _numBinsX;
+        int _numBinsY;
+
+        void collectConnections();
+        double connectionLength(const GPConnection& c) const;
+        void collectCombArea();
+        void solveAxis(bool isX);
+        int solveCG(const CSRMatrix& A, const std::vector<double>& b, std::vector<double>& x);
+        int spreadOverflow();
+    public:
+        GlobalPlacer(Solver* solver);
+        ~GlobalPlacer();
+
+        bool place();
+};
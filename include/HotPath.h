@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+
+/*
+Counters of the hot paths, compiled in only when HOTPATH_COUNTERS is defined (cmake -DHOTPATH_COUNTERS=ON).
+Each thread counts into its own array, the totals are summed when they are printed.
+*/
+enum HotCounter
+{
+    BANKING_CRITICAL_ENTRIES,
+    BANKING_CRITICAL_WAIT_NS,
+    POOL_CRITICAL_ENTRIES,
+    POOL_CRITICAL_WAIT_NS,
+    SLACK_CALLS,
+    SLACK_PATH_INDICES,
+    SLACK_RESCANS,
+    PLACEABLE_REJECT_OFF_SITE,
+    PLACEABLE_REJECT_OUT_OF_DIE,
+    PLACEABLE_REJECT_OVERLAP,
+    NUM_HOT_COUNTERS
+};
+
+class HotPath
+{
+    public:
+        static void add(HotCounter counter, long long n);
+        static int64_t now();
+        // count an entry of a critical section and the time since waitStart
+        static void enterCritical(HotCounter entries, HotCounter waitNs, int64_t waitStart);
+        static long long total(HotCounter counter);
+        static const char* name(HotCounter counter);
+        static void print(std::ostream& out);
+};
+
+#ifdef HOTPATH_COUNTERS
+#define HOTPATH_COUNT(counter) HotPath::add(counter, 1)
+#define HOTPATH_ADD(counter, n) HotPath::add(counter, n)
+// put WAIT_BEGIN right before the critical pragma and ENTERED as the first statement inside it
+#define HOTPATH_CRITICAL_WAIT_BEGIN(var) const int64_t var = HotPath::now()
+#define HOTPATH_CRITICAL_ENTERED(var, site) HotPath::enterCritical(site##_CRITICAL_ENTRIES, site##_CRITICAL_WAIT_NS, var)
+#else
+#define HOTPATH_COUNT(counter) ((void)0)
+#define HOTPATH_ADD(counter, n) ((void)0)
+#define HOTPATH_CRITICAL_WAIT_BEGIN(var) ((void)0)
+#define HOTPATH_CRITICAL_ENTERED(var, site) ((void)0)
+#endif
@@ -0,0 +1,17 @@
+#pragma once
+#include <ostream>
+#include <string>
+
+/*
+Run time access to the hyper parameters of param.h by name.
+A setting is "name=value", a config file has one setting per line and # starts a comment.
+*/
+class HyperParams
+{
+    public:
+        static bool set(const std::string& setting);
+        static bool load(const std::string& filename);
+        // several settings separated by white space, as in a line of a sweep file
+        static bool setAll(const std::string& settings);
+        static void print(std::ostream& out);
+};
@@ -18,6 +18,7 @@ struct SubRow{
 
 
 class LegalPlacer{
+    friend class SolverBench;
     private:
         Solver* _solver;
         std::vector<FF*> _ffs;
@@ -32,5 +33,6 @@ class LegalPlacer{
         ~LegalPlacer();
 
         void legalize();
+        bool legalizeNear(const std::vector<FF*>& ffs);
         void generateSubRows();
 };
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+#include <string>
+#include <deque>
+#include <unordered_map>
+#include <cstdint>
+
+typedef uint32_t NameId;
+
+// name of the trial cells that are never placed, always interned first
+const std::string DUMB_CELL_NAME = "du_mb";
+const NameId DUMB_CELL_ID = 0;
+
+/*
+Global table of instance and pin names, each distinct name is stored once and referred to by its id.
+Names are added only from serial code, ids and the text of interned names never change.
+*/
+class NameTable
+{
+    public:
+        static NameId intern(const std::string& name);
+        static inline const std::string& name(NameId id) { return table()._names[id]; }
+        // return true and set id if name is interned
+        static bool find(const std::string& name, NameId& id);
+    private:
+        NameTable();
+        static NameTable& table();
+
+        // deque keeps references to the names valid when the table grows
+        std::deque<std::string> _names;
+        std::unordered_map<std::string, NameId> _ids;
+};
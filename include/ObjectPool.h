@@ -0,0 +1,83 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include <type_traits>
+#include "HotPath.h"
+
+/*
+Fixed-size allocator for objects of type T.
+Objects are carved from blocks of OBJECT_POOL_BLOCK slots so they stay packed in memory,
+freed slots are kept in a free list and reused by the next allocation, the blocks are released with the pool.
+*/
+template <typename T>
+class ObjectPool
+{
+    public:
+        ObjectPool()
+        {
+            _freeList = nullptr;
+            _next = nullptr;
+            _end = nullptr;
+        }
+        ~ObjectPool()
+        {
+            for (auto block : _blocks)
+            {
+                delete[] block;
+            }
+        }
+
+        void* allocate()
+        {
+            void* p;
+            HOTPATH_CRITICAL_WAIT_BEGIN(waitStart);
+            #ifdef _OPENMP
+            #pragma omp critical(object_pool)
+            #endif
+            {
+                HOTPATH_CRITICAL_ENTERED(waitStart, POOL);
+                if (_freeList != nullptr)
+                {
+                    p = _freeList;
+                    _freeList = _freeList->next;
+                }
+                else
+                {
+                    if (_next == _end)
+                    {
+                        _next = new Slot[OBJECT_POOL_BLOCK];
+                        _end = _next + OBJECT_POOL_BLOCK;
+                        _blocks.push_back(_next);
+                    }
+                    p = _next++;
+                }
+            }
+            return p;
+        }
+
+        void release(void* p)
+        {
+            HOTPATH_CRITICAL_WAIT_BEGIN(waitStart);
+            #ifdef _OPENMP
+            #pragma omp critical(object_pool)
+            #endif
+            {
+                HOTPATH_CRITICAL_ENTERED(waitStart, POOL);
+                Slot* slot = static_cast<Slot*>(p);
+                slot->next = _freeList;
+                _freeList = slot;
+            }
+        }
+
+    private:
+        static const size_t OBJECT_POOL_BLOCK = 1024;
+        union Slot
+        {
+            Slot* next;
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+        };
+        std::vector<Slot*> _blocks;
+        Slot* _freeList;
+        Slot* _next;
+        Slot* _end;
+};
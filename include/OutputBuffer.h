@@ -0,0 +1,27 @@
+#pragma once
+#include <string>
+#include <ostream>
+
+/*
+Growable character buffer for writing large text files, formats integers without going through streams
+and is written to the stream with a single write call.
+*/
+class OutputBuffer
+{
+    public:
+        OutputBuffer();
+        ~OutputBuffer();
+
+        inline void reserve(size_t n) { _buf.reserve(n); }
+        inline void clear() { _buf.clear(); }
+        inline size_t size() const { return _buf.size(); }
+        inline void append(char c) { _buf.push_back(c); }
+        inline void append(const char* s) { _buf.append(s); }
+        inline void append(const char* s, size_t n) { _buf.append(s, n); }
+        inline void append(const std::string& s) { _buf.append(s); }
+
+        void appendInt(long long value);
+        void writeTo(std::ostream& out) const;
+    private:
+        std::string _buf;
+};
@@ -2,6 +2,7 @@
 #include <string>
 #include <queue>
 #include "Cell.h"
+#include "NameTable.h"
 #include "param.h"
 
 class Cell;
@@ -22,11 +23,18 @@ class Pin
 {
     public:
         Pin(PinType type, int x, int y, std::string name, Cell* cell);
+        Pin(PinType type, int x, int y, NameId name, Cell* cell);
         ~Pin();
+
+        // allocated from a pool of the class
+        static void* operator new(std::size_t size);
+        static void operator delete(void* p, std::size_t size);
         
-        inline std::string getName() const { return _name; }
-        inline std::string getOriginalName() const { return _originalCellPinNames[0]; }
-        inline std::vector<std::string> getOriginalNames() const { return _originalCellPinNames; }
+        inline const std::string& getName() const { return NameTable::name(_name); }
+        inline NameId getNameId() const { return _name; }
+        inline const std::string& getOriginalName() const { return NameTable::name(_originalCellPinNames[0]); }
+        inline NameId getOriginalNameId() const { return _originalCellPinNames[0]; }
+        inline const std::vector<NameId>& getOriginalNames() const { return _originalCellPinNames; }
         inline int getX() const { return _x; }
         inline int getY() const { return _y; }
         int getGlobalX() const;
@@ -35,11 +43,12 @@ class Pin
         inline Cell *getCell() const { return _cell; }
         inline PinType getType() const { return _type; }
         inline Pin* getFaninPin() const { return _faninPin; }
-        inline std::vector<Pin*> getFanoutPins() const { return _fanoutPins; }
-        inline std::vector<Pin*> getPrevStagePins() const { return _prevStagePins; }
+        inline const std::vector<Pin*>& getFanoutPins() const { return _fanoutPins; }
+        inline const std::vector<Pin*>& getPrevStagePins() const { return _prevStagePins; }
         inline size_t getPrevStagePinsSize() const { return _prevStagePins.size(); }
-        inline std::vector<Pin*> getPathToPrevStagePins(int idx) const { return _pathToPrevStagePins.at(idx); }
-        inline std::vector<Pin*> getNextStagePins() const { return _nextStagePins; }
+        inline size_t getCriticalIndex() const { return _currCriticalIndex; }
+        inline const std::vector<Pin*>& getPathToPrevStagePins(int idx) const { return _pathToPrevStagePins.at(idx); }
+        inline const std::vector<Pin*>& getNextStagePins() const { return _nextStagePins; }
         inline size_t getNextStagePinsSize() const { return _nextStagePins.size(); }
         inline const std::vector<std::vector<Pin*>>& getPathToNextStagePins() const { return _pathToNextStagePins; }
 
@@ -47,19 +56,26 @@ class Pin
         void setInitSlack(double initSlack);
         void setCell(Cell* cell);
         void setOriginalName();
-        void setOriginalName(std::string ori_name);
-        void addOriginalName(std::string ori_name);
+        void setOriginalName(NameId ori_name);
+        void addOriginalName(NameId ori_name);
         void setFaninPin(Pin* pin);
         void addFanoutPin(Pin* pin);
-        void addPrevStagePin(Pin* pin, std::vector<Pin*> path);
-        void addNextStagePin(Pin* pin, std::vector<Pin*> path);
+        void addPrevStagePin(Pin* pin, const std::vector<Pin*>& path);
+        void addNextStagePin(Pin* pin, const std::vector<Pin*>& path);
         void initArrivalTime();
+        double pathArrivalTime(size_t index) const;
         void resetArrivalTime(bool check = false);
         void modArrivalTime(double delay); // only for FF_D in debug mode
-        inline std::vector<size_t>* getPathIndex(Pin* prevStagePin) { return _prevPathIndexListMap[prevStagePin]; }
+        // nullptr if prevStagePin is not a previous stage pin, never inserts so it is safe to call from many threads
+        inline const std::vector<size_t>* getPathIndex(Pin* prevStagePin) const
+        {
+            auto it = _prevPathIndexListMap.find(prevStagePin);
+            return (it == _prevPathIndexListMap.end()) ? nullptr : it->second;
+        }
         double calSlack(Pin* movedPrevStagePin, int sourceX, int sourceY, int targetX, int targetY, bool update = false);
         double calSlackQ(Pin* changeQPin, double diffQDelay, bool update = false);
         void resetSlack(bool check = false);
+        double recomputeSlack() const;
         void initPathMaps();
 
         void copyConnection(Pin* pin);
@@ -70,8 +86,8 @@ class Pin
         // Pin coordinates(relative to the cell)
         int _x;
         int _y;
-        std::string _name;
-        std::vector<std::string> _originalCellPinNames;
+        NameId _name;
+        std::vector<NameId> _originalCellPinNames;
         // which cell this pin belongs to
         Cell* _cell;
         double _slack;
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstddef>
 #include <vector>
 #include <unordered_map>
 
@@ -39,7 +40,7 @@ class SiteMap
         std::vector<Site*> getSites();
         std::vector<Site*> getSitesOfCell(int leftDownX, int leftDownY, int rightUpX, int rightUpY);
         std::vector<Site*> getSitesInBlock(int leftDownX, int leftDownY, int rightUpX, int rightUpY);
-        inline std::vector<std::vector<Site*>> getSiteRows() const { return _sites; }
+        inline const std::vector<std::vector<Site*>>& getSiteRows() const { return _sites; }
 
         Site* getNearestSite(int x, int y);
 
@@ -47,6 +48,8 @@ class SiteMap
         void removeCell(Cell* cell);
 
         bool onSite(int x, int y);
+
+        friend class SiteRingIterator;
     private:
         bool _hasMultiPlaceRow;
         std::vector<PlacementRows> _placementRows;
@@ -57,4 +60,51 @@ class SiteMap
         // Helper functions
         int getFirstLargerRow(int y);
         int getFirstLargerColInRow(int row, int x);
+};
+
+/*
+Walk the sites in a block outward from a point in rings of row/col index.
+Sites come out in increasing Manhattan distance, a ring is only opened when no site in it can be nearer
+than the sites already found. The visited prefix is kept so the same order can be replayed.
+*/
+class SiteRingIterator
+{
+    public:
+        SiteRingIterator(SiteMap* siteMap);
+
+        void reset(int x, int y, int leftDownX, int leftDownY, int rightUpX, int rightUpY);
+        Site* at(size_t i);
+
+    private:
+        struct Entry
+        {
+            int dist;
+            int row;
+            int col;
+            bool operator>(const Entry& other) const
+            {
+                if (dist != other.dist) return dist > other.dist;
+                if (row != other.row) return row > other.row;
+                return col > other.col;
+            }
+        };
+        SiteMap* _siteMap;
+        int _x;
+        int _y;
+        int _rowLo;
+        int _rowHi;
+        int _r0;
+        int _ring;
+        int _maxRing;
+        int _minSiteWidth;
+        // per row in [_rowLo, _rowHi)
+        std::vector<int> _c0;
+        std::vector<int> _colLo;
+        std::vector<int> _colHi;
+        std::vector<Entry> _heap;
+        std::vector<Site*> _ordered;
+
+        int ringLowerBound(int ring);
+        void openRing(int ring);
+        void push(int row, int col);
 };
\ No newline at end of file
@@ -11,7 +11,11 @@
 #include <climits>
 #include <iomanip>
 #include <chrono>
+#include <functional>
+#include <atomic>
+#include <ctime>
 #include "param.h"
+#include "NameTable.h"
 
 class LibCell;
 class Pin;
@@ -21,7 +25,11 @@ class FF;
 class Site;
 class BinMap;
 class SiteMap;
+class SiteRingIterator;
 class LegalPlacer;
+class GlobalPlacer;
+class OutputBuffer;
+class Evaluator;
 
 struct PlacementRows
 {
@@ -42,6 +50,123 @@ struct PairInfo
     double gain;
 };
 
+struct Rect
+{
+    int x;
+    int y;
+    int w;
+    int h;
+};
+
+struct DebankPlan
+{
+    FF* ff;
+    LibCell* targetFF;
+    std::vector<int> targetX;
+    std::vector<int> targetY;
+    bool debank;
+};
+
+/*
+Banking pair and footprint of the target FFs
+*/
+struct BankingCacheKey
+{
+    NameId ff1;
+    NameId ff2;
+    int width;
+    int height;
+    inline bool operator==(const BankingCacheKey& other) const
+    {
+        return ff1 == other.ff1 && ff2 == other.ff2 && width == other.width && height == other.height;
+    }
+};
+
+struct BankingCacheKeyHash
+{
+    inline size_t operator()(const BankingCacheKey& key) const
+    {
+        size_t h = key.ff1;
+        h = h * 1000003 + key.ff2;
+        h = h * 31 + key.width;
+        h = h * 31 + key.height;
+        return h;
+    }
+};
+
+struct BankingCacheEntry
+{
+    LibCell* targetFF;
+    int targetX;
+    int targetY;
+    double gain;
+    size_t stamp;
+};
+
+/*
+Placement of one FF in a snapshot, its D pins then Q pins start at pinBegin and its clk names at clkBegin
+*/
+struct FFSnapshot
+{
+    NameId instName;
+    LibCell* lib;
+    int x;
+    int y;
+    size_t pinBegin;
+    size_t clkBegin;
+};
+
+/*
+Compact copy of the FF placement and pin mapping, D/Q pins live through the whole solve so they are kept by pointer
+*/
+struct PlacementSnapshot
+{
+    std::vector<FFSnapshot> ffs;
+    std::vector<Pin*> pins;
+    std::vector<NameId> clkNames;
+};
+
+struct CostComponents
+{
+    double tns;
+    double power;
+    double area;
+    int bins;
+};
+
+/*
+Counters of the solver events, they are read before and after each phase
+*/
+struct SolverCounters
+{
+    std::atomic<long long> costEvals{0};
+    std::atomic<long long> placeableCalls{0};
+    std::atomic<long long> movesAccepted{0};
+    std::atomic<long long> banks{0};
+};
+
+/*
+Measurements of one phase (or of the legalization after it) for the run report
+*/
+struct PhaseStats
+{
+    std::string name;
+    double wallTime;
+    double cpuTime;
+    long peakRSS;               // KB
+    long long costEvals;
+    long long placeableCalls;
+    long long movesAccepted;
+    long long banks;
+    size_t numFFs;
+    double cost;
+    CostComponents components;
+    bool legal;
+    // values at the start of the phase
+    std::chrono::steady_clock::time_point wallStart;
+    std::clock_t cpuStart;
+};
+
 class Solver
 {
     public:
@@ -51,13 +176,25 @@ class Solver
         void parse_input(std::string filename);
         void init_placement();
         void solve();
+        void setTimeBudget(double seconds, std::string checkpointFile);
         bool check();
-        void dump(std::vector<std::string>& vecStr) const;
         void dump_best(std::string filename) const;
         void report();
+        void writeReport(std::string filename) const;
+        // re-evaluate the placement from scratch after each phase
+        bool setVerify(std::string inputFile);
+        inline int getVerifyFailures() const { return _verifyFailures; }
+        // compare the incremental slack of a sample of the D pins with a recompute after each phase
+        inline void setTimingCheck(double fraction) { _timingCheckFraction = fraction; }
+        inline int getTimingCheckFailures() const { return _timingCheckFailures; }
+        // -1 before a legal state is saved
+        inline double getBestCost() const { return _bestCost; }
+        inline std::string getBestPhase() const { return _bestCost != -1 ? _stateNames[_bestStateIdx] : ""; }
         
         // friend
         friend class LegalPlacer;
+        friend class GlobalPlacer;
+        friend class SolverBench;
     private:
         // lib
         std::vector<LibCell*> _combsLibList;
@@ -108,7 +245,7 @@ class Solver
         
         void addFF(FF* ff);
         void deleteFF(FF* ff);
-        void bankFFs(FF* ff1, FF* ff2, LibCell* targetFF, int x, int y);
+        FF* bankFFs(FF* ff1, FF* ff2, LibCell* targetFF, int x, int y);
         
         // Trivial
         
@@ -128,26 +265,74 @@ class Solver
         
         // 1. Debank all FFs
         void debankAll();
+        DebankPlan planDebankFF(FF* ff, const std::vector<LibCell*>& oneBitFFs, SiteRingIterator& nearSites, std::vector<Rect>& reserved);
+        bool findDebankSites(FF* ff, LibCell* oneBitFF, SiteRingIterator& nearSites, const std::vector<Rect>& reserved, std::vector<int>& targetX, std::vector<int>& targetY);
         // 2. Force-directed placement
         void iterativePlacementLegal();
+        bool findBestFFMove(FF* ff, int searchDistance, int& bestX, int& bestY, double& bestCost);
+        void calSlackSubgradient(FF* ff, double& gradX, double& gradY);
+        std::vector<std::vector<FF*>> colorFFsForPlacement(const std::vector<FF*>& ffs, const std::unordered_map<Cell*, size_t>& ffIndex, int searchDistance);
+        // move FFs of one conflict-free color in parallel
+        bool _fdColoring = true;
         // 3. Clustering in each clock domain
         std::vector<std::vector<FF*>> clusteringFFs(long unsigned int clkdomain_idx);
         // 4. Greedy banking
         void greedyBanking(std::vector<std::vector<FF*>> clusters);
-        double cal_banking_gain(FF* ff1, FF* ff2, LibCell* targetFF, int& result_x, int& result_y);
+        PairInfo evalBankingPair(FF* ff1, FF* ff2, const std::vector<LibCell*>& targetFFs);
+        std::vector<Site*> bankingCandidateSites(FF* ff1, FF* ff2, LibCell* targetFF);
+        std::vector<size_t> matchBankingPairs(const std::vector<PairInfo>& pairInfos);
+        // memoized banking gains of (pair, footprint)
+        std::unordered_map<BankingCacheKey, BankingCacheEntry, BankingCacheKeyHash> _bankingGainCache;
+        std::unordered_map<NameId, size_t> _bankingDirtyStamp;
+        size_t _bankingStamp = 0;
+        void touchBankingCache(FF* bankedFF, const std::vector<FF*>& cluster);
+        void resetBankingCache();
         // 5. Legalization
         LegalPlacer* _legalizer;
+        // Extra. Global placement
+        GlobalPlacer* _globalPlacer;
         // Extra. Change One Bit FFs
 
+        // Phase scheduling
+        double _timeBudget = 0;
+        std::string _checkpointFile;
+        std::chrono::steady_clock::time_point _solveStart;
+        double _dumpTime = 0;
+        double _checkTime = 0;
+        // measured seconds per FF of each kind of phase
+        std::map<std::string, double> _phaseRate;
+        double remainingTime() const;
+        bool timeUp() const;
+        bool runPhase(std::string name, std::string kind, std::function<void()> body);
+
+        // Instrumentation
+        SolverCounters _counters;
+        std::vector<PhaseStats> _phaseStats;
+        CostComponents calCostComponents();
+        PhaseStats startPhaseStats(std::string name);
+        void endPhaseStats(PhaseStats& stats, bool legal);
+        Evaluator* _verifier = nullptr;
+        int _verifyFailures = 0;
+        void verifyPhase(std::string name);
+        double _timingCheckFraction = 0;
+        int _timingCheckFailures = 0;
+        void checkTiming(std::string name);
+        void runForceDirected();
+        void runBanking();
+
         // State saving
         std::vector<std::string> _stateNames;
         std::vector<double> _stateCosts;
         std::vector<double> _stateTimes;
-        std::vector<std::vector<std::string>> _stateDumps;
+        // only the best state (or the last one before any legal state) is kept
+        PlacementSnapshot _bestSnapshot;
         std::vector<bool> _stateLegal;
         size_t _bestStateIdx;
         double _bestCost = -1;
         void saveState(std::string stateName, bool legal = true);
+        void takeSnapshot(PlacementSnapshot& snapshot);
+        void formatSnapshot(const PlacementSnapshot& snapshot, size_t begin, size_t end, OutputBuffer& instBuf, OutputBuffer& mapBuf) const;
+        void writeSnapshot(const PlacementSnapshot& snapshot, std::ostream& out) const;
 
         // Checker
         bool checkOverlap();
@@ -0,0 +1,45 @@
+#pragma once
+#include <ostream>
+#include <string>
+#include <vector>
+
+class Solver;
+
+/*
+Run the solver with many hyper parameter configurations of one design.
+A sweep file has one configuration per line, settings as in HyperParams separated by white space and # starts a comment.
+The design is parsed once, each configuration is solved in a child process forked from the parsed solver,
+so all of them start from the same in-memory state, and up to jobs children run at a time.
+The best placement of all configurations is written to the output file.
+*/
+class Sweep
+{
+    public:
+        Sweep(Solver* solver, const std::string& outputFile, int jobs, double timeBudget);
+
+        bool load(const std::string& filename);
+        bool run();
+        void print(std::ostream& out) const;
+    private:
+        struct Config
+        {
+            std::string settings;
+            int pid;
+            int pipe;
+            bool ok;
+            double cost;
+            double time;
+            std::string bestPhase;
+        };
+
+        Solver* _solver;
+        std::string _outputFile;
+        int _jobs;
+        double _timeBudget;
+        std::vector<Config> _configs;
+
+        std::string configOutput(size_t idx) const;
+        bool start(size_t idx);
+        void solveConfig(size_t idx, int pipe);
+        void finish(size_t idx, int status);
+};
@@ -0,0 +1,81 @@
+#pragma once
+#include <algorithm>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "param.h"
+
+/*
+Runtime configuration of the OpenMP loops: the number of threads, the schedule of the loops of each phase
+and the binding of the threads to the cores.
+It is read from SOLVER_THREADS, SOLVER_SCHEDULE, SOLVER_BIND and SOLVER_DETERMINISTIC, the command line flags
+override the environment.
+The loops whose best schedule depends on the case use schedule(runtime), the schedule of the phase running
+is set before its body runs.
+*/
+class ThreadConfig
+{
+    public:
+        // number of threads of the parallel loops
+        static int threads();
+        // n threads, 0 for one per processor
+        static bool setThreads(int n);
+        // "kind[,chunk]" for every phase or "phase=kind[,chunk];..." e.g. "fd=dynamic,4;banking=guided",
+        // the phases are debank, gp, fd, banking, legalize and default
+        static bool setSchedule(const std::string& spec);
+        // close, spread, master or false
+        static bool setBind(const std::string& bind);
+        // read the SOLVER_* variables, false if one of them is invalid
+        static bool loadEnvironment();
+        // the OpenMP runtime reads the binding only at start-up, so restart the process with it in the environment
+        static void rebind(char* argv[]);
+        static void applySchedule(const std::string& phase);
+        // the floating point sums are added in a fixed order so a run gives the same result every time
+        static void setDeterministic(bool deterministic);
+        static bool deterministic();
+        // sum of f(0) ... f(n - 1)
+        template <typename F>
+        static double sum(long n, F f);
+        static void print(std::ostream& out);
+};
+
+/*
+An OpenMP reduction adds the partial sums of the threads in the order they finish, the deterministic sum
+adds the partial sums of fixed blocks in block order instead, whatever the thread count and the schedule
+*/
+template <typename F>
+double ThreadConfig::sum(long n, F f)
+{
+    double total = 0;
+    if (!deterministic())
+    {
+        #ifdef _OPENMP
+        #pragma omp parallel for schedule(runtime) reduction(+:total) num_threads(threads())
+        #endif
+        for (long i = 0; i < n; i++)
+        {
+            total += f(i);
+        }
+        return total;
+    }
+    const long numBlocks = (n + DETERMINISTIC_SUM_BLOCK - 1) / DETERMINISTIC_SUM_BLOCK;
+    std::vector<double> partial(numBlocks);
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(runtime) num_threads(threads())
+    #endif
+    for (long b = 0; b < numBlocks; b++)
+    {
+        const long end = std::min(n, (b + 1) * DETERMINISTIC_SUM_BLOCK);
+        double blockSum = 0;
+        for (long i = b * DETERMINISTIC_SUM_BLOCK; i < end; i++)
+        {
+            blockSum += f(i);
+        }
+        partial[b] = blockSum;
+    }
+    for (long b = 0; b < numBlocks; b++)
+    {
+        total += partial[b];
+    }
+    return total;
+}
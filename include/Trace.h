@@ -0,0 +1,55 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include "param.h"
+
+/*
+A traced scope, times are in ns since tracing was enabled
+*/
+struct TraceEvent
+{
+    const char* name;
+    int64_t begin;
+    int64_t end;
+};
+
+/*
+Scoped timeline tracing of the solver phases and the OpenMP loops.
+Each thread records its events into its own ring buffer, so recording takes no lock,
+and the events are written as Chrome trace JSON (chrome://tracing or ui.perfetto.dev).
+While tracing is disabled a scope costs one branch.
+*/
+class Trace
+{
+    public:
+        static void enable(size_t eventsPerThread = TRACE_EVENTS_PER_THREAD);
+        static inline bool enabled() { return _enabled; }
+        static int64_t now();
+        static void record(const char* name, int64_t begin, int64_t end);
+        // copy of a name built at run time that lives until exit, scopes only keep the pointer
+        static const char* label(const std::string& name);
+        // call when no thread is recording
+        static bool write(const std::string& filename);
+    private:
+        static bool _enabled;
+};
+
+class TraceScope
+{
+    public:
+        explicit TraceScope(const char* name) : _name(Trace::enabled() ? name : nullptr), _begin(_name ? Trace::now() : 0) {}
+        ~TraceScope()
+        {
+            if (_name)
+            {
+                Trace::record(_name, _begin, Trace::now());
+            }
+        }
+    private:
+        const char* _name;
+        int64_t _begin;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstddef>
 // cost metrics
 extern double ALPHA;
 extern double BETA;
@@ -16,5 +17,46 @@ extern double BIN_MAX_UTIL;
 // Delay info
 extern double DISP_DELAY;
 
-// Hyper parameters
-const int MAX_CLUSTER_SIZE = 100;
\ No newline at end of file
+// Hyper parameters, defined in HyperParams.cpp with their defaults and settable at run time
+// with --set name=value or --config <file>, see HyperParams.h
+extern int MAX_CLUSTER_SIZE;
+// force-directed placement: search distance in site sizes, max sweeps and min gain of a sweep relative to the cost
+extern double FD_SEARCH_FACTOR;
+extern int FD_MAX_SWEEPS;
+extern double FD_MIN_REL_GAIN;
+// debanking: search distance of the 1-bit FFs in sizes of the debanked FF
+extern double DEBANK_SEARCH_FACTOR;
+// banking: clustering radius as a fraction of the die width, weight of the non-critical pins when placing a bank,
+// share of the displacement delay charged when pruning pairs, radius of the FFs re-evaluated around a new bank
+// in bank sizes and rounds of local augmentation of the pair matching
+extern int BANKING_REGION_DIVISOR;
+extern double BANKING_NONCRITICAL_WEIGHT;
+extern double BANKING_PRUNE_DIVISOR;
+extern double BANKING_DIRTY_FACTOR;
+extern int BANKING_MATCH_ROUNDS;
+// legalization: row search distance as a fraction of the die height and first search radius of an orphan in FF sizes
+extern int LEGAL_SEARCH_DIVISOR;
+extern double LEGAL_ORPHAN_RADIUS_FACTOR;
+// global placement: min FFs to run it, rounds, anchor weight and its growth in overflowed bins,
+// weight of connections with positive slack, min length of a reweighted term and CG stopping criteria
+extern int GP_MIN_FFS;
+extern int GP_ITERATIONS;
+extern double GP_ANCHOR_WEIGHT;
+extern double GP_DENSITY_FACTOR;
+extern double GP_NONCRITICAL_WEIGHT;
+extern int GP_MIN_LENGTH;
+extern int GP_CG_MAX_ITER;
+extern double GP_CG_TOLERANCE;
+// time budget: estimated seconds per FF of each phase before it is measured,
+// and the fraction of the estimate a cut phase needs to be started
+extern double EST_DEBANK_TIME_PER_FF;
+extern double EST_GP_TIME_PER_FF;
+extern double EST_FD_TIME_PER_FF;
+extern double EST_BANKING_TIME_PER_FF;
+extern double MIN_TRUNCATED_PHASE;
+// timing check: largest difference between an incremental and a recomputed slack that is not an error
+const double TIMING_CHECK_TOLERANCE = 1e-6;
+// deterministic mode: elements of a block of a parallel sum, the blocks are added in order
+const long DETERMINISTIC_SUM_BLOCK = 4096;
+// tracing: events kept per thread, older events are overwritten when the ring is full
+const size_t TRACE_EVENTS_PER_THREAD = 1 << 20;
@@ -179,10 +179,9 @@ double BinMap::addCell(Cell* cell, int x, int y, bool trial)
 
 double BinMap::trialLibCell(LibCell* libCell, int x, int y)
 {
-    Cell* cell = new Cell(x, y, "du_mb", libCell);
-    double causedCost = addCell(cell, true);
-    delete cell;
-    return causedCost;
+    // the trial cell is never stored, keep it on the stack
+    Cell cell(x, y, DUMB_CELL_ID, libCell);
+    return addCell(&cell, true);
 }
 
 double BinMap::removeCell(Cell* cell, bool trial)
@@ -23,14 +23,39 @@ LibCell::~LibCell()
     }
 }
 
+/*
+Index the pins in the order the instance cells copy them
+*/
+void LibCell::indexPins()
+{
+    pinIndex.clear();
+    size_t idx = 0;
+    for (auto pin : inputPins)
+    {
+        pinIndex[pin->getNameId()] = idx++;
+    }
+    for (auto pin : outputPins)
+    {
+        pinIndex[pin->getNameId()] = idx++;
+    }
+    if (clkPin != nullptr)
+    {
+        pinIndex[clkPin->getNameId()] = idx++;
+    }
+}
+
 Cell::Cell()
 {
     _x = 0;
     _y = 0;
-    _inst_name = "";
+    _inst_name = NameTable::intern("");
+}
+
+Cell::Cell(int x, int y, std::string inst_name, LibCell* lib_cell) : Cell(x, y, NameTable::intern(inst_name), lib_cell)
+{
 }
 
-Cell::Cell(int x, int y, std::string inst_name, LibCell* lib_cell)
+Cell::Cell(int x, int y, NameId inst_name, LibCell* lib_cell)
 {
     _x = x;
     _y = y;
@@ -38,7 +63,7 @@ Cell::Cell(int x, int y, std::string inst_name, LibCell* lib_cell)
     _lib_cell = lib_cell;
     // copy pins and set cell
 
-    if(inst_name == "du_mb"){
+    if(inst_name == DUMB_CELL_ID){
         return;
     }
 
@@ -72,16 +97,22 @@ Cell::~Cell()
 {
 }
 
-Pin* Cell::getPin(std::string pin_name)
+/*
+Find the pin by name through the pin index of the lib cell, only valid for the cells built from the input
+*/
+Pin* Cell::getPin(const std::string& pin_name)
 {
-    for (auto pin : _pins)
+    NameId id;
+    if (!NameTable::find(pin_name, id))
     {
-        if (pin->getName() == pin_name)
-        {
-            return pin;
-        }
+        return nullptr;
+    }
+    auto it = _lib_cell->pinIndex.find(id);
+    if (it == _lib_cell->pinIndex.end() || it->second >= _pins.size())
+    {
+        return nullptr;
     }
-    return nullptr;
+    return _pins[it->second];
 }
 
 void Cell::setXY(int x, int y)
@@ -90,9 +121,9 @@ void Cell::setXY(int x, int y)
     this->_y = y;
 }
 
-void Cell::setInstName(std::string inst_name)
+void Cell::setInstName(const std::string& inst_name)
 {
-    this->_inst_name = inst_name;
+    this->_inst_name = NameTable::intern(inst_name);
 }
 
 void Cell::addPin(Pin* pin)
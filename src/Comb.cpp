@@ -1,4 +1,34 @@
 #include "Comb.h"
+#include "ObjectPool.h"
+
+static ObjectPool<Comb>& combPool()
+{
+    static ObjectPool<Comb> pool;
+    return pool;
+}
+
+void* Comb::operator new(std::size_t size)
+{
+    if (size != sizeof(Comb))
+    {
+        return ::operator new(size);
+    }
+    return combPool().allocate();
+}
+
+void Comb::operator delete(void* p, std::size_t size)
+{
+    if (p == nullptr)
+    {
+        return;
+    }
+    if (size != sizeof(Comb))
+    {
+        ::operator delete(p);
+        return;
+    }
+    combPool().release(p);
+}
 
 Comb::~Comb()
 {
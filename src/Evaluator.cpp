@@ -0,0 +1,803 @@
+#include "Evaluator.h"
+#include "ThreadConfig.h"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <cctype>
+#include <cstdlib>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+Evaluator::Evaluator()
+{
+    _alpha = _beta = _gamma = _lambda = 0;
+    _dieLowLeftX = _dieLowLeftY = _dieUpRightX = _dieUpRightY = 0;
+    _binWidth = _binHeight = 1;
+    _binMaxUtil = 100;
+    _dispDelay = 0;
+    _maxMessages = 10;
+}
+
+Evaluator::~Evaluator()
+{
+}
+
+/*
+Add an instance and a timing node for each of its library pins
+*/
+void Evaluator::addInst(std::vector<Inst>& insts, std::unordered_map<std::string, int>& index, const std::string& name, int lib, int x, int y)
+{
+    const int instIdx = insts.size();
+    insts.push_back(Inst{name, lib, x, y, (int)_nodeType.size()});
+    index[name] = instIdx;
+    for (auto& pin : _libs[lib].pins)
+    {
+        _nodeType.push_back(pin.type);
+        _nodeX.push_back(x + pin.x);
+        _nodeY.push_back(y + pin.y);
+        _nodeDriver.push_back(-1);
+        _nodeInst.push_back(instIdx);
+    }
+}
+
+/*
+Timing node of "inst/pin" or of a port, -1 if there is none
+*/
+int Evaluator::findNode(const std::string& pinName) const
+{
+    const size_t slash = pinName.rfind('/');
+    if (slash == std::string::npos)
+    {
+        auto it = _portIndex.find(pinName);
+        return (it == _portIndex.end()) ? -1 : it->second;
+    }
+    const std::string instName = pinName.substr(0, slash);
+    const std::string pin = pinName.substr(slash + 1);
+    const Inst* inst = nullptr;
+    auto ffIt = _ffIndex.find(instName);
+    if (ffIt != _ffIndex.end())
+    {
+        inst = &_ffs[ffIt->second];
+    }
+    else
+    {
+        auto gateIt = _gateIndex.find(instName);
+        if (gateIt == _gateIndex.end())
+        {
+            return -1;
+        }
+        inst = &_gates[gateIt->second];
+    }
+    const Lib& lib = _libs[inst->lib];
+    auto pinIt = lib.pinIndex.find(pin);
+    return (pinIt == lib.pinIndex.end()) ? -1 : inst->nodeBase + pinIt->second;
+}
+
+bool Evaluator::loadInput(const std::string& filename)
+{
+    std::ifstream in(filename);
+    if (!in.good())
+    {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return false;
+    }
+    std::string token;
+    int numNets = 0;
+    int unknownPins = 0;
+    while (in >> token)
+    {
+        if (token == "Alpha")
+        {
+            in >> _alpha;
+        }
+        else if (token == "Beta")
+        {
+            in >> _beta;
+        }
+        else if (token == "Gamma")
+        {
+            in >> _gamma;
+        }
+        else if (token == "Lambda")
+        {
+            in >> _lambda;
+        }
+        else if (token == "DieSize")
+        {
+            in >> _dieLowLeftX >> _dieLowLeftY >> _dieUpRightX >> _dieUpRightY;
+        }
+        else if (token == "Input" || token == "Output")
+        {
+            std::string name;
+            int x, y;
+            in >> name >> x >> y;
+            _portIndex[name] = _nodeType.size();
+            _nodeType.push_back(token == "Input" ? NODE_INPUT : NODE_OUTPUT);
+            _nodeX.push_back(x);
+            _nodeY.push_back(y);
+            _nodeDriver.push_back(-1);
+            _nodeInst.push_back(-1);
+        }
+        else if (token == "FlipFlop" || token == "Gate")
+        {
+            Lib lib;
+            lib.ff = (token == "FlipFlop");
+            lib.bits = 0;
+            lib.qDelay = 0;
+            lib.power = 0;
+            int pinCount;
+            if (lib.ff)
+            {
+                in >> lib.bits;
+            }
+            in >> lib.name >> lib.width >> lib.height >> pinCount;
+            for (int i = 0; i < pinCount; i++)
+            {
+                LibPin pin;
+                in >> token >> pin.name >> pin.x >> pin.y;
+                const char c = std::tolower(pin.name[0]);
+                if (lib.ff && (c == 'd' || c == 'q' || c == 'c'))
+                {
+                    pin.type = (c == 'd') ? NODE_FF_D : (c == 'q') ? NODE_FF_Q : NODE_FF_CLK;
+                }
+                else if (!lib.ff && (c == 'i' || c == 'o'))
+                {
+                    pin.type = (c == 'i') ? NODE_GATE_IN : NODE_GATE_OUT;
+                }
+                else
+                {
+                    continue;
+                }
+                lib.pinIndex[pin.name] = lib.pins.size();
+                lib.pins.push_back(pin);
+            }
+            _libIndex[lib.name] = _libs.size();
+            _libs.push_back(lib);
+        }
+        else if (token == "Inst")
+        {
+            std::string name, libName;
+            int x, y;
+            in >> name >> libName >> x >> y;
+            auto it = _libIndex.find(libName);
+            if (it == _libIndex.end())
+            {
+                std::cerr << "Error: unknown library cell " << libName << " of " << name << std::endl;
+                continue;
+            }
+            if (_libs[it->second].ff)
+            {
+                addInst(_ffs, _ffIndex, name, it->second, x, y);
+            }
+            else
+            {
+                addInst(_gates, _gateIndex, name, it->second, x, y);
+            }
+        }
+        else if (token == "Net")
+        {
+            std::string netName;
+            int pinCount;
+            in >> netName >> pinCount;
+            std::vector<int> nodes;
+            for (int i = 0; i < pinCount; i++)
+            {
+                std::string pinName;
+                in >> token >> pinName;
+                const int node = findNode(pinName);
+                if (node < 0)
+                {
+                    unknownPins++;
+                    continue;
+                }
+                nodes.push_back(node);
+            }
+            // the first output of the net drives it
+            int driver = -1;
+            for (int node : nodes)
+            {
+                const NodeType type = _nodeType[node];
+                if (type == NODE_FF_Q || type == NODE_GATE_OUT || type == NODE_INPUT)
+                {
+                    driver = node;
+                    break;
+                }
+            }
+            for (int node : nodes)
+            {
+                if (node != driver)
+                {
+                    _nodeDriver[node] = driver;
+                }
+                if (_nodeType[node] == NODE_FF_CLK)
+                {
+                    _ffClkNet.resize(_ffs.size(), -1);
+                    _ffClkNet[_nodeInst[node]] = numNets;
+                }
+            }
+            numNets++;
+        }
+        else if (token == "BinWidth")
+        {
+            in >> _binWidth;
+        }
+        else if (token == "BinHeight")
+        {
+            in >> _binHeight;
+        }
+        else if (token == "BinMaxUtil")
+        {
+            in >> _binMaxUtil;
+        }
+        else if (token == "PlacementRows")
+        {
+            Row row;
+            in >> row.startX >> row.startY >> row.siteWidth >> row.siteHeight >> row.numSites;
+            _rowsAtY[row.startY].push_back(_rows.size());
+            _rows.push_back(row);
+        }
+        else if (token == "DisplacementDelay")
+        {
+            in >> _dispDelay;
+        }
+        else if (token == "QpinDelay" || token == "GatePower")
+        {
+            std::string libName;
+            double value;
+            in >> libName >> value;
+            auto it = _libIndex.find(libName);
+            if (it != _libIndex.end())
+            {
+                (token == "QpinDelay" ? _libs[it->second].qDelay : _libs[it->second].power) = value;
+            }
+        }
+        else if (token == "TimingSlack")
+        {
+            std::string instName, pin;
+            double slack;
+            in >> instName >> pin >> slack;
+            const int node = findNode(instName + "/" + pin);
+            if (node < 0)
+            {
+                std::cerr << "Error: unknown timing slack pin " << instName << "/" << pin << std::endl;
+                continue;
+            }
+            _initSlack.resize(_nodeType.size(), 0);
+            _initSlack[node] = slack;
+        }
+        else if (token == "NumInput" || token == "NumOutput" || token == "NumInstances" || token == "NumNets")
+        {
+            in >> token;
+        }
+        else
+        {
+            std::cerr << "Error: unexpected token " << token << " in " << filename << std::endl;
+            return false;
+        }
+    }
+    if (unknownPins > 0)
+    {
+        std::cerr << "Warning: " << unknownPins << " net pins are not ports or instance pins" << std::endl;
+    }
+    _ffClkNet.resize(_ffs.size(), -1);
+    _initSlack.resize(_nodeType.size(), 0);
+    _dNodes.clear();
+    for (size_t node = 0; node < _nodeType.size(); node++)
+    {
+        if (_nodeType[node] == NODE_FF_D)
+        {
+            _dNodes.push_back(node);
+        }
+    }
+    levelize();
+    std::vector<double> qDelay(_nodeType.size(), 0);
+    for (auto& ff : _ffs)
+    {
+        const Lib& lib = _libs[ff.lib];
+        for (size_t p = 0; p < lib.pins.size(); p++)
+        {
+            qDelay[ff.nodeBase + p] = lib.qDelay;
+        }
+    }
+    propagate(_nodeX, _nodeY, qDelay, _initArrival);
+    return true;
+}
+
+/*
+Sort the gates into levels, gates on a combinational loop are left out and their outputs never arrive
+*/
+void Evaluator::levelize()
+{
+    const size_t numGates = _gates.size();
+    std::vector<int> pending(numGates, 0);
+    std::vector<std::vector<int>> fanoutGates(numGates);
+    for (size_t g = 0; g < numGates; g++)
+    {
+        const Inst& gate = _gates[g];
+        const Lib& lib = _libs[gate.lib];
+        for (size_t p = 0; p < lib.pins.size(); p++)
+        {
+            if (lib.pins[p].type != NODE_GATE_IN)
+            {
+                continue;
+            }
+            const int driver = _nodeDriver[gate.nodeBase + p];
+            if (driver >= 0 && _nodeType[driver] == NODE_GATE_OUT)
+            {
+                fanoutGates[_nodeInst[driver]].push_back(g);
+                pending[g]++;
+            }
+        }
+    }
+    _levels.clear();
+    std::vector<int> level;
+    for (size_t g = 0; g < numGates; g++)
+    {
+        if (pending[g] == 0)
+        {
+            level.push_back(g);
+        }
+    }
+    size_t numLevelized = 0;
+    while (!level.empty())
+    {
+        numLevelized += level.size();
+        std::vector<int> next;
+        for (int g : level)
+        {
+            for (int fanout : fanoutGates[g])
+            {
+                if (--pending[fanout] == 0)
+                {
+                    next.push_back(fanout);
+                }
+            }
+        }
+        _levels.push_back(level);
+        level.swap(next);
+    }
+    if (numLevelized < numGates)
+    {
+        std::cerr << "Warning: " << numGates - numLevelized << " gates are on combinational loops" << std::endl;
+    }
+}
+
+/*
+Longest arrival time at every driver pin, -INFINITY if no path from an input or an FF reaches it.
+Only the wires count, the delays inside the gates do not change with the placement.
+*/
+void Evaluator::propagate(const std::vector<int>& x, const std::vector<int>& y, const std::vector<double>& qDelay, std::vector<double>& arrival) const
+{
+    const long numNodes = _nodeType.size();
+    arrival.assign(numNodes, -INFINITY);
+    for (long node = 0; node < numNodes; node++)
+    {
+        if (_nodeType[node] == NODE_INPUT)
+        {
+            arrival[node] = 0;
+        }
+        else if (_nodeType[node] == NODE_FF_Q)
+        {
+            arrival[node] = qDelay[node];
+        }
+    }
+    for (auto& level : _levels)
+    {
+        const long numGates = level.size();
+        #ifdef _OPENMP
+        #pragma omp parallel for schedule(static) num_threads(ThreadConfig::threads())
+        #endif
+        for (long i = 0; i < numGates; i++)
+        {
+            const Inst& gate = _gates[level[i]];
+            const std::vector<LibPin>& pins = _libs[gate.lib].pins;
+            double out = -INFINITY;
+            for (size_t p = 0; p < pins.size(); p++)
+            {
+                if (pins[p].type == NODE_GATE_IN)
+                {
+                    out = std::max(out, dArrival(gate.nodeBase + p, x, y, arrival));
+                }
+            }
+            for (size_t p = 0; p < pins.size(); p++)
+            {
+                if (pins[p].type == NODE_GATE_OUT)
+                {
+                    arrival[gate.nodeBase + p] = out;
+                }
+            }
+        }
+    }
+}
+
+/*
+Arrival time at a sink pin through the wire from its driver
+*/
+double Evaluator::dArrival(int node, const std::vector<int>& x, const std::vector<int>& y, const std::vector<double>& arrival) const
+{
+    const int driver = _nodeDriver[node];
+    if (driver < 0 || arrival[driver] == -INFINITY)
+    {
+        return -INFINITY;
+    }
+    return arrival[driver] + (std::abs(x[node] - x[driver]) + std::abs(y[node] - y[driver])) * _dispDelay;
+}
+
+bool Evaluator::onSite(int x, int y) const
+{
+    auto it = _rowsAtY.find(y);
+    if (it == _rowsAtY.end())
+    {
+        return false;
+    }
+    for (int r : it->second)
+    {
+        const Row& row = _rows[r];
+        if (x >= row.startX && (x - row.startX) % row.siteWidth == 0 && (x - row.startX) / row.siteWidth < row.numSites)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+Number of bins whose utilization by the given FFs and the gates is at least the max utilization
+*/
+int Evaluator::countBins(const std::vector<Inst>& insts) const
+{
+    const long numBinsX = (_dieUpRightX - _dieLowLeftX + _binWidth - 1) / _binWidth;
+    const long numBinsY = (_dieUpRightY - _dieLowLeftY + _binHeight - 1) / _binHeight;
+    std::vector<long long> binArea(numBinsX * numBinsY, 0);
+    auto addCell = [&](const Inst& inst)
+    {
+        const Lib& lib = _libs[inst.lib];
+        const int x1 = std::max(inst.x, _dieLowLeftX);
+        const int y1 = std::max(inst.y, _dieLowLeftY);
+        const int x2 = std::min(inst.x + lib.width, _dieUpRightX);
+        const int y2 = std::min(inst.y + lib.height, _dieUpRightY);
+        for (long by = (y1 - _dieLowLeftY) / _binHeight; by < numBinsY && _dieLowLeftY + by * _binHeight < y2; by++)
+        {
+            const long binY = _dieLowLeftY + by * _binHeight;
+            const long h = std::min<long>(y2, binY + _binHeight) - std::max<long>(y1, binY);
+            for (long bx = (x1 - _dieLowLeftX) / _binWidth; bx < numBinsX && _dieLowLeftX + bx * _binWidth < x2; bx++)
+            {
+                const long binX = _dieLowLeftX + bx * _binWidth;
+                const long w = std::min<long>(x2, binX + _binWidth) - std::max<long>(x1, binX);
+                if (w > 0 && h > 0)
+                {
+                    binArea[by * numBinsX + bx] += (long long)w * h;
+                }
+            }
+        }
+    };
+    for (auto& inst : insts)
+    {
+        addCell(inst);
+    }
+    for (auto& gate : _gates)
+    {
+        addCell(gate);
+    }
+    const double binArea100 = (double)_binWidth * _binHeight / 100.;
+    int count = 0;
+    for (long long area : binArea)
+    {
+        if (area / binArea100 >= _binMaxUtil)
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+/*
+Count the FFs off site or out of the die and the overlapping pairs of cells.
+Cells are bucketed by bin, a pair is counted in the bucket of the lower left corner of its overlap.
+*/
+int Evaluator::checkPlacement(const std::vector<Inst>& insts, int& messages) const
+{
+    int errors = 0;
+    auto error = [&](const std::string& message)
+    {
+        errors++;
+        if (messages++ < _maxMessages)
+        {
+            std::cerr << "Error: " << message << std::endl;
+        }
+    };
+    const long numBinsX = (_dieUpRightX - _dieLowLeftX + _binWidth - 1) / _binWidth;
+    const long numBinsY = (_dieUpRightY - _dieLowLeftY + _binHeight - 1) / _binHeight;
+    // cells by bucket, FFs as index, gates as -1 - index
+    std::vector<std::vector<int>> buckets(numBinsX * numBinsY);
+    auto bucketCell = [&](const Inst& inst, int id)
+    {
+        const Lib& lib = _libs[inst.lib];
+        const long bx1 = std::max<long>(0, (inst.x - _dieLowLeftX) / _binWidth);
+        const long by1 = std::max<long>(0, (inst.y - _dieLowLeftY) / _binHeight);
+        const long bx2 = std::min<long>(numBinsX - 1, (inst.x + lib.width - 1 - _dieLowLeftX) / _binWidth);
+        const long by2 = std::min<long>(numBinsY - 1, (inst.y + lib.height - 1 - _dieLowLeftY) / _binHeight);
+        for (long by = by1; by <= by2; by++)
+        {
+            for (long bx = bx1; bx <= bx2; bx++)
+            {
+                buckets[by * numBinsX + bx].push_back(id);
+            }
+        }
+    };
+    for (size_t i = 0; i < insts.size(); i++)
+    {
+        const Inst& inst = insts[i];
+        const Lib& lib = _libs[inst.lib];
+        if (inst.x < _dieLowLeftX || inst.y < _dieLowLeftY || inst.x + lib.width > _dieUpRightX || inst.y + lib.height > _dieUpRightY)
+        {
+            error("FF " + inst.name + " is out of the die");
+            continue;
+        }
+        if (!onSite(inst.x, inst.y))
+        {
+            error("FF " + inst.name + " is not on a site");
+        }
+        bucketCell(inst, i);
+    }
+    for (size_t g = 0; g < _gates.size(); g++)
+    {
+        bucketCell(_gates[g], -1 - (int)g);
+    }
+    for (long b = 0; b < numBinsX * numBinsY; b++)
+    {
+        const std::vector<int>& cells = buckets[b];
+        const long binX = _dieLowLeftX + (b % numBinsX) * _binWidth;
+        const long binY = _dieLowLeftY + (b / numBinsX) * _binHeight;
+        for (size_t i = 0; i < cells.size(); i++)
+        {
+            if (cells[i] < 0)
+            {
+                continue;
+            }
+            const Inst& a = insts[cells[i]];
+            const Lib& libA = _libs[a.lib];
+            for (size_t j = 0; j < cells.size(); j++)
+            {
+                // FF pairs once, gate pairs never
+                if (j == i || (cells[j] >= 0 && j < i))
+                {
+                    continue;
+                }
+                const Inst& c = (cells[j] >= 0) ? insts[cells[j]] : _gates[-1 - cells[j]];
+                const Lib& libC = _libs[c.lib];
+                const int x1 = std::max(a.x, c.x);
+                const int y1 = std::max(a.y, c.y);
+                if (x1 >= std::min(a.x + libA.width, c.x + libC.width) || y1 >= std::min(a.y + libA.height, c.y + libC.height))
+                {
+                    continue;
+                }
+                if (x1 < binX || x1 >= binX + _binWidth || y1 < binY || y1 >= binY + _binHeight)
+                {
+                    continue;
+                }
+                error("FF " + a.name + " overlaps " + c.name);
+            }
+        }
+    }
+    return errors;
+}
+
+bool Evaluator::evaluate(const std::string& filename, EvalResult& result)
+{
+    std::ifstream in(filename, std::ios::binary);
+    if (!in.good())
+    {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return false;
+    }
+    return evaluate(in, result);
+}
+
+/*
+Evaluate an output, the errors are counted in the result and the first ones are printed.
+Return false only if the output cannot be read.
+*/
+bool Evaluator::evaluate(std::istream& in, EvalResult& result)
+{
+    result = EvalResult();
+    int messages = 0;
+    auto mappingError = [&](const std::string& message)
+    {
+        result.mappingErrors++;
+        if (messages++ < _maxMessages)
+        {
+            std::cerr << "Error: " << message << std::endl;
+        }
+    };
+    std::string token;
+    long numInsts;
+    if (!(in >> token >> numInsts) || token != "CellInst")
+    {
+        std::cerr << "Error: output does not start with CellInst" << std::endl;
+        return false;
+    }
+    std::vector<Inst> insts;
+    std::unordered_map<std::string, int> instIndex;
+    for (long i = 0; i < numInsts; i++)
+    {
+        std::string name, libName;
+        int x, y;
+        if (!(in >> token >> name >> libName >> x >> y) || token != "Inst")
+        {
+            std::cerr << "Error: output has fewer than " << numInsts << " instances" << std::endl;
+            return false;
+        }
+        auto it = _libIndex.find(libName);
+        if (it == _libIndex.end() || !_libs[it->second].ff)
+        {
+            mappingError("instance " + name + " is not a flip-flop: " + libName);
+            continue;
+        }
+        if (instIndex.count(name) > 0)
+        {
+            mappingError("instance " + name + " is defined twice");
+            continue;
+        }
+        instIndex[name] = insts.size();
+        insts.push_back(Inst{name, it->second, x, y, 0});
+    }
+    result.numInsts = insts.size();
+
+    // map every pin of the input FFs to a pin of an output instance
+    const size_t numNodes = _nodeType.size();
+    std::vector<int> mapInst(numNodes, -1);
+    std::vector<int> mapPin(numNodes, -1);
+    std::unordered_map<long long, int> pinUses;
+    // clock net of each output instance, -2 once a second clock is found
+    std::vector<int> instClkNet(insts.size(), -1);
+    auto addClock = [&](int inst, int ff)
+    {
+        int& clkNet = instClkNet[inst];
+        if (clkNet == -1)
+        {
+            clkNet = _ffClkNet[ff];
+        }
+        else if (clkNet != -2 && clkNet != _ffClkNet[ff])
+        {
+            mappingError("instance " + insts[inst].name + " has flip-flops of different clocks");
+            clkNet = -2;
+        }
+    };
+    std::string from, to;
+    while (in >> from >> token >> to)
+    {
+        const int node = findNode(from);
+        if (node < 0 || _nodeInst[node] < 0 || (_nodeType[node] != NODE_FF_D && _nodeType[node] != NODE_FF_Q && _nodeType[node] != NODE_FF_CLK))
+        {
+            mappingError("mapped pin " + from + " is not a pin of an input flip-flop");
+            continue;
+        }
+        // a debanked FF maps its clock pin to each of its new FFs
+        if (mapInst[node] >= 0 && _nodeType[node] != NODE_FF_CLK)
+        {
+            mappingError("pin " + from + " is mapped twice");
+            continue;
+        }
+        const size_t slash = to.rfind('/');
+        auto instIt = (slash == std::string::npos) ? instIndex.end() : instIndex.find(to.substr(0, slash));
+        if (instIt == instIndex.end())
+        {
+            mappingError("pin " + from + " is mapped to " + to + " of no output instance");
+            continue;
+        }
+        const Lib& lib = _libs[insts[instIt->second].lib];
+        auto pinIt = lib.pinIndex.find(to.substr(slash + 1));
+        if (pinIt == lib.pinIndex.end() || lib.pins[pinIt->second].type != _nodeType[node])
+        {
+            mappingError("pin " + from + " is mapped to " + to + " of another kind");
+            continue;
+        }
+        if (_nodeType[node] != NODE_FF_CLK && pinUses[((long long)instIt->second << 32) | pinIt->second]++ > 0)
+        {
+            mappingError("pin " + to + " has more than one pin mapped to it");
+        }
+        addClock(instIt->second, _nodeInst[node]);
+        if (mapInst[node] < 0)
+        {
+            mapInst[node] = instIt->second;
+            mapPin[node] = pinIt->second;
+        }
+    }
+
+    // every pin mapped and D and Q of a bit stay paired
+    for (size_t f = 0; f < _ffs.size(); f++)
+    {
+        const Inst& ff = _ffs[f];
+        const std::vector<LibPin>& pins = _libs[ff.lib].pins;
+        for (size_t p = 0; p < pins.size(); p++)
+        {
+            const int node = ff.nodeBase + p;
+            if (mapInst[node] < 0)
+            {
+                mappingError("pin " + ff.name + "/" + pins[p].name + " is not mapped");
+                continue;
+            }
+            if (pins[p].type != NODE_FF_D)
+            {
+                continue;
+            }
+            auto qIt = _libs[ff.lib].pinIndex.find("Q" + pins[p].name.substr(1));
+            if (qIt == _libs[ff.lib].pinIndex.end())
+            {
+                continue;
+            }
+            const int qNode = ff.nodeBase + qIt->second;
+            if (mapInst[qNode] < 0)
+            {
+                continue;
+            }
+            const std::vector<LibPin>& newPins = _libs[insts[mapInst[node]].lib].pins;
+            if (mapInst[qNode] != mapInst[node] || newPins[mapPin[node]].name.substr(1) != newPins[mapPin[qNode]].name.substr(1))
+            {
+                mappingError("pins " + ff.name + "/" + pins[p].name + " and " + ff.name + "/" + pins[qIt->second].name + " are not mapped to one bit");
+            }
+        }
+    }
+
+    // timing with the pins moved to their new places
+    std::vector<int> x = _nodeX;
+    std::vector<int> y = _nodeY;
+    std::vector<double> qDelay(numNodes, 0);
+    for (size_t node = 0; node < numNodes; node++)
+    {
+        if (mapInst[node] < 0)
+        {
+            continue;
+        }
+        const Inst& inst = insts[mapInst[node]];
+        const Lib& lib = _libs[inst.lib];
+        x[node] = inst.x + lib.pins[mapPin[node]].x;
+        y[node] = inst.y + lib.pins[mapPin[node]].y;
+        qDelay[node] = lib.qDelay;
+    }
+    std::vector<double> arrival;
+    propagate(x, y, qDelay, arrival);
+    const long numD = _dNodes.size();
+    const double tns = ThreadConfig::sum(numD, [&](long i) {
+        const int node = _dNodes[i];
+        const double initArrival = dArrival(node, _nodeX, _nodeY, _initArrival);
+        double slack = _initSlack[node];
+        if (initArrival != -INFINITY)
+        {
+            slack += initArrival - dArrival(node, x, y, arrival);
+        }
+        return slack < 0 ? -slack : 0.0;
+    });
+    result.tns = tns;
+    for (auto& inst : insts)
+    {
+        const Lib& lib = _libs[inst.lib];
+        result.power += lib.power;
+        result.area += (double)lib.width * lib.height;
+    }
+    result.bins = countBins(insts);
+    result.placementErrors = checkPlacement(insts, messages);
+    result.cost = _alpha * result.tns + _beta * result.power + _gamma * result.area + _lambda * result.bins;
+    if (messages > _maxMessages)
+    {
+        std::cerr << "... " << messages - _maxMessages << " more errors" << std::endl;
+    }
+    return true;
+}
+
+void Evaluator::print(const EvalResult& result, std::ostream& out) const
+{
+    out << "Instances: " << result.numInsts << "\n";
+    out << "TNS: " << result.tns << "\n";
+    out << "Power: " << result.power << "\n";
+    out << "Area: " << result.area << "\n";
+    out << "Num of bins violated: " << result.bins << "\n";
+    const std::streamsize precision = out.precision(10);
+    out << "Cost: " << result.cost << "\n";
+    out.precision(precision);
+    out << "Mapping errors: " << result.mappingErrors << "\n";
+    out << "Placement errors: " << result.placementErrors << std::endl;
+}
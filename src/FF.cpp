@@ -1,5 +1,35 @@
 #include "FF.h"
 #include <iostream>
+#include "ObjectPool.h"
+
+static ObjectPool<FF>& ffPool()
+{
+    static ObjectPool<FF> pool;
+    return pool;
+}
+
+void* FF::operator new(std::size_t size)
+{
+    if (size != sizeof(FF))
+    {
+        return ::operator new(size);
+    }
+    return ffPool().allocate();
+}
+
+void FF::operator delete(void* p, std::size_t size)
+{
+    if (p == nullptr)
+    {
+        return;
+    }
+    if (size != sizeof(FF))
+    {
+        ::operator delete(p);
+        return;
+    }
+    ffPool().release(p);
+}
 /*
 Constructor for single bits
 */
@@ -7,14 +37,14 @@ FF::FF(int x, int y, std::string inst_name, LibCell* lib_cell, std::pair<Pin*, P
 {
     _x = x;
     _y = y;
-    _inst_name = inst_name;
+    _inst_name = NameTable::intern(inst_name);
     _lib_cell = lib_cell;
 
     // clk
     Pin* libClkPin = lib_cell->clkPin;
-    _clkPin = new Pin(PinType::FF_CLK, libClkPin->getX(), libClkPin->getY(), libClkPin->getName(), this);
+    _clkPin = new Pin(PinType::FF_CLK, libClkPin->getX(), libClkPin->getY(), libClkPin->getNameId(), this);
     _clkPin->copyConnection(clk);
-    _clkPin->setOriginalName(clk->getOriginalName());
+    _clkPin->setOriginalName(clk->getOriginalNameId());
 
     // d
     Pin* newInPin = dqpair.first;
@@ -33,14 +63,14 @@ FF::FF(int x, int y, std::string inst_name, LibCell* lib_cell, std::vector<std::
 {
     _x = x;
     _y = y;
-    _inst_name = inst_name;
+    _inst_name = NameTable::intern(inst_name);
     _lib_cell = lib_cell;
 
     // clk
     Pin* libClkPin = lib_cell->clkPin;
-    _clkPin = new Pin(PinType::FF_CLK, libClkPin->getX(), libClkPin->getY(), libClkPin->getName(), this);
+    _clkPin = new Pin(PinType::FF_CLK, libClkPin->getX(), libClkPin->getY(), libClkPin->getNameId(), this);
     _clkPin->copyConnection(clk);
-    _clkPin->setOriginalName(clk->getOriginalName());
+    _clkPin->setOriginalName(clk->getOriginalNameId());
 
     for(size_t i=0;i<dqpairs.size();i++)
     {
@@ -65,17 +95,16 @@ FF::FF(int x, int y, std::string inst_name, LibCell* lib_cell, std::vector<std::
 {
     _x = x;
     _y = y;
-    _inst_name = inst_name;
+    _inst_name = NameTable::intern(inst_name);
     _lib_cell = lib_cell;
 
     // clk
     Pin* libClkPin = lib_cell->clkPin;
-    _clkPin = new Pin(PinType::FF_CLK, libClkPin->getX(), libClkPin->getY(), libClkPin->getName(), this);
+    _clkPin = new Pin(PinType::FF_CLK, libClkPin->getX(), libClkPin->getY(), libClkPin->getNameId(), this);
     _clkPin->copyConnection(clks[0]);
     for (auto clk : clks)
     {
-        std::vector<std::string> ori_names = clk->getOriginalNames();
-        for (auto ori_name : ori_names)
+        for (auto ori_name : clk->getOriginalNames())
         {
             _clkPin->addOriginalName(ori_name);
         }
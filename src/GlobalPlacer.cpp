@@ -0,0 +1,368 @@
+#include "GlobalPlacer.h"
+#include "Solver.h"
+#include "Cell.h"
+#include "Comb.h"
+#include "FF.h"
+#include "Pin.h"
+#include "Bin.h"
+#include "LegalPlacer.h"
+#include "Trace.h"
+#include "ThreadConfig.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+GlobalPlacer::GlobalPlacer(Solver* solver)
+{
+    _solver = solver;
+}
+
+GlobalPlacer::~GlobalPlacer()
+{
+}
+
+/*
+Place the FFs globally and legalize them.
+Minimize the Manhattan length of the connections with negative slack with every FF anchored to its position,
+the L1 length is approximated by reweighted quadratic terms and each axis is solved with preconditioned CG.
+Before every round the slack of each connection is updated by its length, so connections that
+become positive are relaxed and the ones that become negative are pulled.
+FFs in overflowed bins get heavier anchors before the next round.
+Return false and keep the old placement if the cost does not improve.
+*/
+bool GlobalPlacer::place()
+{
+    _ffs = _solver->_ffs;
+    if (_ffs.size() < size_t(GP_MIN_FFS))
+    {
+        return false;
+    }
+    _ffIndex.clear();
+    for (size_t i = 0; i < _ffs.size(); i++)
+    {
+        _ffIndex[_ffs[i]] = i;
+    }
+    _x.resize(_ffs.size());
+    _y.resize(_ffs.size());
+    _anchorX.resize(_ffs.size());
+    _anchorY.resize(_ffs.size());
+    _anchorWeight.assign(_ffs.size(), GP_ANCHOR_WEIGHT);
+    for (size_t i = 0; i < _ffs.size(); i++)
+    {
+        _x[i] = _anchorX[i] = _ffs[i]->getX();
+        _y[i] = _anchorY[i] = _ffs[i]->getY();
+    }
+    collectConnections();
+    if (_connections.empty())
+    {
+        return false;
+    }
+    collectCombArea();
+
+    for (int iter = 0; iter < GP_ITERATIONS; iter++)
+    {
+        solveAxis(true);
+        solveAxis(false);
+        const int overflow = spreadOverflow();
+        std::cout << "Global placement iteration " << iter << ", FFs in overflowed bins: " << overflow << std::endl;
+    }
+
+    const double oldCost = _solver->_currCost;
+    for (auto ff : _ffs)
+    {
+        _solver->removeCell(ff);
+    }
+    // FFs moving less keep their sites first
+    std::vector<FF*> order = _ffs;
+    std::vector<double> move(_ffs.size());
+    for (size_t i = 0; i < _ffs.size(); i++)
+    {
+        FF* ff = _ffs[i];
+        const int x = std::min(std::max(int(std::lround(_x[i])), DIE_LOW_LEFT_X), DIE_UP_RIGHT_X - ff->getWidth());
+        const int y = std::min(std::max(int(std::lround(_y[i])), DIE_LOW_LEFT_Y), DIE_UP_RIGHT_Y - ff->getHeight());
+        move[i] = std::abs(x - _anchorX[i]) + std::abs(y - _anchorY[i]);
+        ff->setXY(x, y);
+    }
+    std::stable_sort(order.begin(), order.end(), [this, &move](FF* a, FF* b) -> bool {
+        return move[_ffIndex.at(a)] < move[_ffIndex.at(b)];
+    });
+    if (!_solver->_legalizer->legalizeNear(order))
+    {
+        _solver->_legalizer->legalize();
+    }
+    _solver->resetSlack(false);
+    const double newCost = _solver->calCost();
+    if (newCost < oldCost)
+    {
+        _solver->_currCost = newCost;
+        return true;
+    }
+
+    // restore the old placement
+    std::cout << "Global placement does not improve the cost, restore" << std::endl;
+    for (auto ff : _ffs)
+    {
+        _solver->removeCell(ff);
+    }
+    for (size_t i = 0; i < _ffs.size(); i++)
+    {
+        _solver->placeCell(_ffs[i], int(_anchorX[i]), int(_anchorY[i]));
+    }
+    _solver->resetSlack(false);
+    _solver->_currCost = _solver->calCost();
+    return false;
+}
+
+/*
+Collect the D pin to fanin connections and the Q pin to next stage connections on the critical path of the next stage D pins
+*/
+void GlobalPlacer::collectConnections()
+{
+    _connections.clear();
+    auto addConnection = [this](int i, Pin* pin, Pin* other, double slack) {
+        GPConnection c;
+        c.i = i;
+        c.offXi = pin->getX();
+        c.offYi = pin->getY();
+        c.j = -1;
+        c.offXj = 0;
+        c.offYj = 0;
+        c.fixedX = other->getGlobalX();
+        c.fixedY = other->getGlobalY();
+        auto it = _ffIndex.find(other->getCell());
+        if (other->getCell() != nullptr && it != _ffIndex.end())
+        {
+            if (it->second == i)
+                return;
+            c.j = it->second;
+            c.offXj = other->getX();
+            c.offYj = other->getY();
+        }
+        c.slack = slack;
+        c.length = 0;
+        _connections.push_back(c);
+        _connections.back().length = connectionLength(_connections.back());
+    };
+    for (size_t i = 0; i < _ffs.size(); i++)
+    {
+        FF* ff = _ffs[i];
+        for (auto inPin : ff->getInputPins())
+        {
+            Pin* faninPin = inPin->getFaninPin();
+            if (faninPin == nullptr)
+                continue;
+            addConnection(i, inPin, faninPin, inPin->getSlack());
+        }
+        for (auto outPin : ff->getOutputPins())
+        {
+            for (auto nextStagePin : outPin->getNextStagePins())
+            {
+                if (nextStagePin->getType() != PinType::FF_D)
+                    continue;
+                const size_t critical = nextStagePin->getCriticalIndex();
+                const std::vector<size_t>* indexList = nextStagePin->getPathIndex(outPin);
+                if (indexList == nullptr || std::find(indexList->begin(), indexList->end(), critical) == indexList->end())
+                    continue;
+                const std::vector<Pin*>& path = nextStagePin->getPathToPrevStagePins(critical);
+                Pin* secondLastPin = path.at(path.size()-2);
+                // a direct Q to D connection is already added by the D side
+                if (secondLastPin == nextStagePin && _ffIndex.count(nextStagePin->getCell()))
+                    continue;
+                addConnection(i, outPin, secondLastPin, nextStagePin->getSlack());
+            }
+        }
+    }
+}
+
+double GlobalPlacer::connectionLength(const GPConnection& c) const
+{
+    const double otherX = (c.j == -1) ? c.fixedX : _x[c.j] + c.offXj;
+    const double otherY = (c.j == -1) ? c.fixedY : _y[c.j] + c.offYj;
+    return std::abs(_x[c.i] + c.offXi - otherX) + std::abs(_y[c.i] + c.offYi - otherY);
+}
+
+/*
+Collect the area of the combs in each bin
+*/
+void GlobalPlacer::collectCombArea()
+{
+    _numBinsX = (DIE_UP_RIGHT_X - DIE_LOW_LEFT_X + BIN_WIDTH - 1) / BIN_WIDTH;
+    _numBinsY = (DIE_UP_RIGHT_Y - DIE_LOW_LEFT_Y + BIN_HEIGHT - 1) / BIN_HEIGHT;
+    _combArea.assign(_numBinsX * _numBinsY, 0);
+    for (auto bin : _solver->_binMap->getBins())
+    {
+        const int bx = (bin->getX() - DIE_LOW_LEFT_X) / BIN_WIDTH;
+        const int by = (bin->getY() - DIE_LOW_LEFT_Y) / BIN_HEIGHT;
+        for (auto cell : bin->getCells())
+        {
+            if (cell->getCellType() == CellType::COMB)
+            {
+                _combArea[by * _numBinsX + bx] += bin->calOverlapArea(cell);
+            }
+        }
+    }
+}
+
+/*
+Solve one axis of the reweighted quadratic problem, the weight of a term is 1 / its current length
+*/
+void GlobalPlacer::solveAxis(bool isX)
+{
+    TRACE_SCOPE("solveAxis");
+    const int n = _ffs.size();
+    std::vector<double>& pos = isX ? _x : _y;
+    const std::vector<double>& anchor = isX ? _anchorX : _anchorY;
+    std::vector<std::vector<std::pair<int, double>>> offDiag(n);
+    std::vector<double> diag(n, 0);
+    std::vector<double> b(n, 0);
+    auto reweight = [](double length) -> double {
+        return 1.0 / std::max(std::abs(length), double(GP_MIN_LENGTH));
+    };
+
+    for (int i = 0; i < n; i++)
+    {
+        const double w = _anchorWeight[i] * reweight(pos[i] - anchor[i]);
+        diag[i] += w;
+        b[i] += w * anchor[i];
+    }
+    for (auto& c : _connections)
+    {
+        // only connections with negative slack pay for their length
+        const double slack = c.slack - DISP_DELAY * (connectionLength(c) - c.length);
+        const double crit = (slack < 0) ? 1.0 : GP_NONCRITICAL_WEIGHT;
+        const double offI = isX ? c.offXi : c.offYi;
+        if (c.j == -1)
+        {
+            const double fixed = isX ? c.fixedX : c.fixedY;
+            const double w = crit * reweight(pos[c.i] + offI - fixed);
+            diag[c.i] += w;
+            b[c.i] += w * (fixed - offI);
+        }
+        else
+        {
+            const double offJ = isX ? c.offXj : c.offYj;
+            const double w = crit * reweight(pos[c.i] + offI - pos[c.j] - offJ);
+            diag[c.i] += w;
+            diag[c.j] += w;
+            offDiag[c.i].emplace_back(c.j, -w);
+            offDiag[c.j].emplace_back(c.i, -w);
+            b[c.i] += w * (offJ - offI);
+            b[c.j] += w * (offI - offJ);
+        }
+    }
+
+    CSRMatrix A;
+    A.diag = diag;
+    A.rowStart.resize(n + 1, 0);
+    for (int i = 0; i < n; i++)
+    {
+        A.rowStart[i + 1] = A.rowStart[i] + offDiag[i].size();
+    }
+    A.cols.resize(A.rowStart[n]);
+    A.vals.resize(A.rowStart[n]);
+    for (int i = 0; i < n; i++)
+    {
+        int k = A.rowStart[i];
+        for (auto& entry : offDiag[i])
+        {
+            A.cols[k] = entry.first;
+            A.vals[k] = entry.second;
+            k++;
+        }
+    }
+    solveCG(A, b, pos);
+}
+
+/*
+Jacobi preconditioned conjugate gradient, x is the initial guess and the solution, return the number of iterations
+*/
+int GlobalPlacer::solveCG(const CSRMatrix& A, const std::vector<double>& b, std::vector<double>& x)
+{
+    const int n = x.size();
+    std::vector<double> r(n), z(n), p(n), Ap(n);
+    auto multiply = [&A, n](const std::vector<double>& v, std::vector<double>& out) {
+        #ifdef _OPENMP
+        #pragma omp parallel for schedule(runtime) num_threads(ThreadConfig::threads())
+        #endif
+        for (int i = 0; i < n; i++)
+        {
+            double sum = A.diag[i] * v[i];
+            for (int k = A.rowStart[i]; k < A.rowStart[i + 1]; k++)
+            {
+                sum += A.vals[k] * v[A.cols[k]];
+            }
+            out[i] = sum;
+        }
+    };
+    auto dot = [n](const std::vector<double>& u, const std::vector<double>& v) -> double {
+        return ThreadConfig::sum(n, [&u, &v](long i) { return u[i] * v[i]; });
+    };
+
+    multiply(x, Ap);
+    for (int i = 0; i < n; i++)
+    {
+        r[i] = b[i] - Ap[i];
+        z[i] = r[i] / A.diag[i];
+        p[i] = z[i];
+    }
+    const double bNorm = std::sqrt(dot(b, b));
+    double rz = dot(r, z);
+    int iter = 0;
+    for (; iter < GP_CG_MAX_ITER; iter++)
+    {
+        if (std::sqrt(dot(r, r)) <= GP_CG_TOLERANCE * bNorm)
+            break;
+        multiply(p, Ap);
+        const double alpha = rz / dot(p, Ap);
+        #ifdef _OPENMP
+        #pragma omp parallel for schedule(runtime) num_threads(ThreadConfig::threads())
+        #endif
+        for (int i = 0; i < n; i++)
+        {
+            x[i] += alpha * p[i];
+            r[i] -= alpha * Ap[i];
+            z[i] = r[i] / A.diag[i];
+        }
+        const double rzNew = dot(r, z);
+        const double beta = rzNew / rz;
+        rz = rzNew;
+        #ifdef _OPENMP
+        #pragma omp parallel for schedule(runtime) num_threads(ThreadConfig::threads())
+        #endif
+        for (int i = 0; i < n; i++)
+        {
+            p[i] = z[i] + beta * p[i];
+        }
+    }
+    return iter;
+}
+
+/*
+Make the anchors of FFs in bins over the max utilization heavier, return the number of such FFs
+*/
+int GlobalPlacer::spreadOverflow()
+{
+    TRACE_SCOPE("spreadOverflow");
+    std::vector<double> area = _combArea;
+    std::vector<int> binOf(_ffs.size());
+    for (size_t i = 0; i < _ffs.size(); i++)
+    {
+        const double cx = _x[i] + _ffs[i]->getWidth() / 2.0;
+        const double cy = _y[i] + _ffs[i]->getHeight() / 2.0;
+        const int bx = std::min(std::max(int((cx - DIE_LOW_LEFT_X) / BIN_WIDTH), 0), _numBinsX - 1);
+        const int by = std::min(std::max(int((cy - DIE_LOW_LEFT_Y) / BIN_HEIGHT), 0), _numBinsY - 1);
+        binOf[i] = by * _numBinsX + bx;
+        area[binOf[i]] += _ffs[i]->getArea();
+    }
+    int overflow = 0;
+    const double maxArea = BIN_MAX_UTIL / 100. * BIN_WIDTH * BIN_HEIGHT;
+    for (size_t i = 0; i < _ffs.size(); i++)
+    {
+        if (area[binOf[i]] > maxArea)
+        {
+            _anchorWeight[i] *= GP_DENSITY_FACTOR;
+            overflow++;
+        }
+    }
+    return overflow;
+}
@@ -0,0 +1,101 @@
+#include "HotPath.h"
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+
+struct ThreadCounters
+{
+    long long values[NUM_HOT_COUNTERS];
+};
+
+std::mutex countersMutex;
+std::vector<std::unique_ptr<ThreadCounters>> threadCounters;
+thread_local ThreadCounters* localCounters = nullptr;
+
+/*
+Give the calling thread its counters, they outlive the thread so its counts are kept
+*/
+ThreadCounters* registerThread()
+{
+    std::lock_guard<std::mutex> lock(countersMutex);
+    std::unique_ptr<ThreadCounters> counters(new ThreadCounters());
+    for (auto& value : counters->values)
+    {
+        value = 0;
+    }
+    localCounters = counters.get();
+    threadCounters.push_back(std::move(counters));
+    return localCounters;
+}
+
+const char* counterNames[NUM_HOT_COUNTERS] = {
+    "banking_critical_entries",
+    "banking_critical_wait_ns",
+    "pool_critical_entries",
+    "pool_critical_wait_ns",
+    "slack_calls",
+    "slack_path_indices",
+    "slack_rescans",
+    "placeable_reject_off_site",
+    "placeable_reject_out_of_die",
+    "placeable_reject_overlap",
+};
+
+}
+
+void HotPath::add(HotCounter counter, long long n)
+{
+    ThreadCounters* counters = localCounters ? localCounters : registerThread();
+    counters->values[counter] += n;
+}
+
+int64_t HotPath::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void HotPath::enterCritical(HotCounter entries, HotCounter waitNs, int64_t waitStart)
+{
+    ThreadCounters* counters = localCounters ? localCounters : registerThread();
+    counters->values[entries]++;
+    counters->values[waitNs] += now() - waitStart;
+}
+
+/*
+Sum of a counter over the threads, call when no parallel region is running
+*/
+long long HotPath::total(HotCounter counter)
+{
+    std::lock_guard<std::mutex> lock(countersMutex);
+    long long sum = 0;
+    for (auto& counters : threadCounters)
+    {
+        sum += counters->values[counter];
+    }
+    return sum;
+}
+
+const char* HotPath::name(HotCounter counter)
+{
+    return counterNames[counter];
+}
+
+void HotPath::print(std::ostream& out)
+{
+    out << "------------------------- Hot path counters ----------------------" << std::endl;
+    for (int i = 0; i < NUM_HOT_COUNTERS; i++)
+    {
+        out << std::setw(32) << std::left << counterNames[i] << std::right << total(HotCounter(i)) << std::endl;
+    }
+    const long long calls = total(SLACK_CALLS);
+    if (calls > 0)
+    {
+        out << std::setw(32) << std::left << "slack_path_indices_per_call" << std::right << std::fixed << std::setprecision(2) << double(total(SLACK_PATH_INDICES)) / calls << std::endl;
+    }
+    out << "------------------------------------------------------------------" << std::endl;
+}
@@ -0,0 +1,173 @@
+#include "HyperParams.h"
+#include "param.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// defaults of the hyper parameters
+int MAX_CLUSTER_SIZE = 100;
+double FD_SEARCH_FACTOR = 2;
+int FD_MAX_SWEEPS = 4;
+double FD_MIN_REL_GAIN = 1e-4;
+double DEBANK_SEARCH_FACTOR = 1;
+int BANKING_REGION_DIVISOR = 50;
+double BANKING_NONCRITICAL_WEIGHT = 1e-3;
+double BANKING_PRUNE_DIVISOR = 2;
+double BANKING_DIRTY_FACTOR = 2;
+int BANKING_MATCH_ROUNDS = 10;
+int LEGAL_SEARCH_DIVISOR = 50;
+double LEGAL_ORPHAN_RADIUS_FACTOR = 2;
+int GP_MIN_FFS = 10000;
+int GP_ITERATIONS = 5;
+double GP_ANCHOR_WEIGHT = 1.0;
+double GP_DENSITY_FACTOR = 2.0;
+double GP_NONCRITICAL_WEIGHT = 0.05;
+int GP_MIN_LENGTH = 100;
+int GP_CG_MAX_ITER = 200;
+double GP_CG_TOLERANCE = 1e-6;
+double EST_DEBANK_TIME_PER_FF = 3e-5;
+double EST_GP_TIME_PER_FF = 3e-5;
+double EST_FD_TIME_PER_FF = 1e-4;
+double EST_BANKING_TIME_PER_FF = 5e-4;
+double MIN_TRUNCATED_PHASE = 0.2;
+
+namespace
+{
+
+struct HyperParam
+{
+    const char* name;
+    int* intValue;
+    double* doubleValue;
+    // smallest valid value, the divisors and search factors must stay positive
+    double minValue;
+};
+
+#define HYPER_INT(name, minValue) {#name, &name, nullptr, minValue}
+#define HYPER_DOUBLE(name, minValue) {#name, nullptr, &name, minValue}
+
+const HyperParam hyperParams[] = {
+    HYPER_INT(MAX_CLUSTER_SIZE, 2),
+    HYPER_DOUBLE(FD_SEARCH_FACTOR, 0),
+    HYPER_INT(FD_MAX_SWEEPS, 0),
+    HYPER_DOUBLE(FD_MIN_REL_GAIN, 0),
+    HYPER_DOUBLE(DEBANK_SEARCH_FACTOR, 0),
+    HYPER_INT(BANKING_REGION_DIVISOR, 1),
+    HYPER_DOUBLE(BANKING_NONCRITICAL_WEIGHT, 0),
+    HYPER_DOUBLE(BANKING_PRUNE_DIVISOR, 1e-9),
+    HYPER_DOUBLE(BANKING_DIRTY_FACTOR, 0),
+    HYPER_INT(BANKING_MATCH_ROUNDS, 0),
+    HYPER_INT(LEGAL_SEARCH_DIVISOR, 1),
+    HYPER_DOUBLE(LEGAL_ORPHAN_RADIUS_FACTOR, 0.5),
+    HYPER_INT(GP_MIN_FFS, 0),
+    HYPER_INT(GP_ITERATIONS, 0),
+    HYPER_DOUBLE(GP_ANCHOR_WEIGHT, 1e-9),
+    HYPER_DOUBLE(GP_DENSITY_FACTOR, 1),
+    HYPER_DOUBLE(GP_NONCRITICAL_WEIGHT, 0),
+    HYPER_INT(GP_MIN_LENGTH, 1),
+    HYPER_INT(GP_CG_MAX_ITER, 1),
+    HYPER_DOUBLE(GP_CG_TOLERANCE, 0),
+    HYPER_DOUBLE(EST_DEBANK_TIME_PER_FF, 0),
+    HYPER_DOUBLE(EST_GP_TIME_PER_FF, 0),
+    HYPER_DOUBLE(EST_FD_TIME_PER_FF, 0),
+    HYPER_DOUBLE(EST_BANKING_TIME_PER_FF, 0),
+    HYPER_DOUBLE(MIN_TRUNCATED_PHASE, 0),
+};
+
+#undef HYPER_INT
+#undef HYPER_DOUBLE
+
+}
+
+bool HyperParams::set(const std::string& setting)
+{
+    const size_t eq = setting.find('=');
+    if (eq == std::string::npos)
+    {
+        std::cerr << "Error: Expected name=value: " << setting << std::endl;
+        return false;
+    }
+    const std::string name = setting.substr(0, eq);
+    const std::string value = setting.substr(eq + 1);
+    for (const HyperParam& param : hyperParams)
+    {
+        if (name != param.name)
+        {
+            continue;
+        }
+        char* end = nullptr;
+        const double parsed = param.intValue != nullptr ? std::strtol(value.c_str(), &end, 10) : std::strtod(value.c_str(), &end);
+        if (value.empty() || *end != '\0')
+        {
+            std::cerr << "Error: Invalid value of " << name << ": " << value << std::endl;
+            return false;
+        }
+        if (parsed < param.minValue)
+        {
+            std::cerr << "Error: " << name << " must be at least " << param.minValue << std::endl;
+            return false;
+        }
+        if (param.intValue != nullptr)
+        {
+            *param.intValue = int(parsed);
+        }
+        else
+        {
+            *param.doubleValue = parsed;
+        }
+        return true;
+    }
+    std::cerr << "Error: Unknown hyper parameter: " << name << std::endl;
+    return false;
+}
+
+bool HyperParams::setAll(const std::string& settings)
+{
+    std::stringstream ss(settings);
+    std::string setting;
+    while (ss >> setting)
+    {
+        if (!set(setting))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool HyperParams::load(const std::string& filename)
+{
+    std::ifstream in(filename);
+    if (!in)
+    {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line))
+    {
+        if (!setAll(line.substr(0, line.find('#'))))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void HyperParams::print(std::ostream& out)
+{
+    for (const HyperParam& param : hyperParams)
+    {
+        out << param.name << "=";
+        if (param.intValue != nullptr)
+        {
+            out << *param.intValue;
+        }
+        else
+        {
+            out << *param.doubleValue;
+        }
+        out << "\n";
+    }
+}
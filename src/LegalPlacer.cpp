@@ -2,6 +2,9 @@
 #include "Solver.h"
 #include "FF.h"
 #include "Site.h"
+#include "Cell.h"
+#include "Trace.h"
+#include "ThreadConfig.h"
 
 SubRow::SubRow(std::vector<Site*> sites){
     _sites = sites;
@@ -28,7 +31,7 @@ void LegalPlacer::removeAllFFs(){
 void LegalPlacer::generateSubRows(){
     // Row are separated by Combs
     _subRows.clear();
-    std::vector<std::vector<Site*>> siteRow = _solver->_siteMap->getSiteRows();
+    const std::vector<std::vector<Site*>>& siteRow = _solver->_siteMap->getSiteRows();
     std::vector<Site*> subRow;
     for(size_t i = 0;i < siteRow.size();i++){
         for(size_t j = 0;j < siteRow.at(i).size();j++){
@@ -102,6 +105,7 @@ double LegalPlacer::placeRow(FF* ff, int subRowIndex, bool trial){
 }
 
 void LegalPlacer::legalize(){
+    TRACE_SCOPE("legalize");
     _ffs = _solver->_ffs;
     double totalMove = 0;
     removeAllFFs();
@@ -115,7 +119,7 @@ void LegalPlacer::legalize(){
 
     std::vector<int> orphans;
     // HYPER
-    int searchDistance = (DIE_UP_RIGHT_Y-DIE_LOW_LEFT_Y)/50;
+    int searchDistance = (DIE_UP_RIGHT_Y-DIE_LOW_LEFT_Y)/LEGAL_SEARCH_DIVISOR;
     if (searchDistance < 1)
     {
         searchDistance = DIE_UP_RIGHT_Y-DIE_LOW_LEFT_Y;
@@ -148,12 +152,16 @@ void LegalPlacer::legalize(){
         int max_distance = 3*searchDistance;
         while(best_subrow == -1 && max_distance < (DIE_UP_RIGHT_Y-DIE_LOW_LEFT_Y)){
             std::vector<int> nearSubRows = getNearSubRows(_ffs[orphans[i]], min_distance, max_distance);
-            #pragma omp parallel for num_threads(4)
+            // the costs are compared in the order of the rows so a tie goes to the first row whatever the thread timing
+            std::vector<double> costs(nearSubRows.size());
+            #pragma omp parallel for schedule(runtime) num_threads(ThreadConfig::threads())
             for(long unsigned int j = 0;j < nearSubRows.size();j++){
-                double cost = placeRow(_ffs[orphans[i]], nearSubRows[j], true);
-                #pragma omp critical
-                if(cost < cost_min){
-                    cost_min = cost;
+                TRACE_SCOPE("placeOrphan");
+                costs[j] = placeRow(_ffs[orphans[i]], nearSubRows[j], true);
+            }
+            for(long unsigned int j = 0;j < nearSubRows.size();j++){
+                if(costs[j] < cost_min){
+                    cost_min = costs[j];
                     best_subrow = nearSubRows[j];
                 }
             }
@@ -170,4 +178,43 @@ void LegalPlacer::legalize(){
 
     std::cout << "Legalizing done." << std::endl;
     std::cout << "Total movement: " << totalMove << std::endl;
-}
\ No newline at end of file
+}
+/*
+Place each of ffs (removed from the maps, at its target x and y) on the nearest free site, in the given order.
+The search window doubles until the whole die is covered, return false if some FF cannot be placed.
+*/
+bool LegalPlacer::legalizeNear(const std::vector<FF*>& ffs){
+    SiteRingIterator nearSites(_solver->_siteMap);
+    bool allPlaced = true;
+    double totalMove = 0;
+    const int dieSize = std::max(DIE_UP_RIGHT_X-DIE_LOW_LEFT_X, DIE_UP_RIGHT_Y-DIE_LOW_LEFT_Y);
+    for(FF* ff : ffs){
+        const int x = ff->getX();
+        const int y = ff->getY();
+        bool placed = false;
+        // HYPER
+        int radius = LEGAL_ORPHAN_RADIUS_FACTOR*std::max(ff->getWidth(), ff->getHeight());
+        while(!placed){
+            nearSites.reset(x, y, std::max(x-radius, DIE_LOW_LEFT_X), std::max(y-radius, DIE_LOW_LEFT_Y),
+                            std::min(x+radius, DIE_UP_RIGHT_X), std::min(y+radius, DIE_UP_RIGHT_Y));
+            for(size_t i = 0; Site* site = nearSites.at(i); i++){
+                if(_solver->placeable(ff, site->getX(), site->getY())){
+                    _solver->placeCell(ff, site->getX(), site->getY());
+                    totalMove += abs(site->getX()-x) + abs(site->getY()-y);
+                    placed = true;
+                    break;
+                }
+            }
+            if(radius >= dieSize)
+                break;
+            radius *= 2;
+        }
+        if(!placed){
+            allPlaced = false;
+            std::cerr << "There is no place for " << ff->getInstName() << std::endl;
+        }
+    }
+    std::cout << "Legalizing near done." << std::endl;
+    std::cout << "Total movement: " << totalMove << std::endl;
+    return allPlaced;
+}
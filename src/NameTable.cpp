@@ -0,0 +1,39 @@
+#include "NameTable.h"
+
+NameTable::NameTable()
+{
+    _names.push_back(DUMB_CELL_NAME);
+    _ids[DUMB_CELL_NAME] = DUMB_CELL_ID;
+}
+
+NameTable& NameTable::table()
+{
+    static NameTable instance;
+    return instance;
+}
+
+NameId NameTable::intern(const std::string& name)
+{
+    NameTable& t = table();
+    auto it = t._ids.find(name);
+    if (it != t._ids.end())
+    {
+        return it->second;
+    }
+    const NameId id = t._names.size();
+    t._names.push_back(name);
+    t._ids[name] = id;
+    return id;
+}
+
+bool NameTable::find(const std::string& name, NameId& id)
+{
+    NameTable& t = table();
+    auto it = t._ids.find(name);
+    if (it == t._ids.end())
+    {
+        return false;
+    }
+    id = it->second;
+    return true;
+}
@@ -0,0 +1,58 @@
+#include "OutputBuffer.h"
+
+OutputBuffer::OutputBuffer()
+{
+}
+
+OutputBuffer::~OutputBuffer()
+{
+}
+
+/*
+Append the decimal digits of value, two digits at a time from a lookup table
+*/
+void OutputBuffer::appendInt(long long value)
+{
+    static const char digitPairs[201] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+    char tmp[24];
+    char* end = tmp + sizeof(tmp);
+    char* p = end;
+    unsigned long long v = (value < 0) ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+    while (v >= 100)
+    {
+        unsigned idx = (v % 100) * 2;
+        v /= 100;
+        *--p = digitPairs[idx + 1];
+        *--p = digitPairs[idx];
+    }
+    if (v >= 10)
+    {
+        unsigned idx = v * 2;
+        *--p = digitPairs[idx + 1];
+        *--p = digitPairs[idx];
+    }
+    else
+    {
+        *--p = char('0' + v);
+    }
+    if (value < 0)
+    {
+        *--p = '-';
+    }
+    _buf.append(p, end - p);
+}
+
+void OutputBuffer::writeTo(std::ostream& out) const
+{
+    out.write(_buf.data(), _buf.size());
+}
@@ -1,8 +1,43 @@
 #include "Pin.h"
 #include <iostream>
 #include <algorithm>
+#include "ObjectPool.h"
+#include "HotPath.h"
 
-Pin::Pin(PinType type, int x, int y, std::string name, Cell* cell)
+static ObjectPool<Pin>& pinPool()
+{
+    static ObjectPool<Pin> pool;
+    return pool;
+}
+
+void* Pin::operator new(std::size_t size)
+{
+    if (size != sizeof(Pin))
+    {
+        return ::operator new(size);
+    }
+    return pinPool().allocate();
+}
+
+void Pin::operator delete(void* p, std::size_t size)
+{
+    if (p == nullptr)
+    {
+        return;
+    }
+    if (size != sizeof(Pin))
+    {
+        ::operator delete(p);
+        return;
+    }
+    pinPool().release(p);
+}
+
+Pin::Pin(PinType type, int x, int y, std::string name, Cell* cell) : Pin(type, x, y, NameTable::intern(name), cell)
+{
+}
+
+Pin::Pin(PinType type, int x, int y, NameId name, Cell* cell)
 {
     _type = type;
     _x = x;
@@ -50,16 +85,16 @@ void Pin::setCell(Cell* cell)
 void Pin::setOriginalName()
 {
     _originalCellPinNames.clear();
-    _originalCellPinNames.push_back(this->getCell()->getInstName() + "/" + this->getName());
+    _originalCellPinNames.push_back(NameTable::intern(this->getCell()->getInstName() + "/" + this->getName()));
 }
 
-void Pin::setOriginalName(std::string ori_name)
+void Pin::setOriginalName(NameId ori_name)
 {
     _originalCellPinNames.clear();
     _originalCellPinNames.push_back(ori_name);
 }
 
-void Pin::addOriginalName(std::string ori_name)
+void Pin::addOriginalName(NameId ori_name)
 {
     _originalCellPinNames.push_back(ori_name);
 }
@@ -74,16 +109,16 @@ void Pin::addFanoutPin(Pin* pin)
     _fanoutPins.push_back(pin);
 }
 
-void Pin::addPrevStagePin(Pin* pin, std::vector<Pin*> path)
+void Pin::addPrevStagePin(Pin* pin, const std::vector<Pin*>& path)
 {
     _prevStagePins.push_back(pin);
-    _pathToPrevStagePins.push_back(std::vector<Pin*>(path));
+    _pathToPrevStagePins.push_back(path);
 }
 
-void Pin::addNextStagePin(Pin* pin, std::vector<Pin*> path)
+void Pin::addNextStagePin(Pin* pin, const std::vector<Pin*>& path)
 {
     _nextStagePins.push_back(pin);
-    _pathToNextStagePins.push_back(std::vector<Pin*>(path));
+    _pathToNextStagePins.push_back(path);
 }
 
 void Pin::copyConnection(Pin* pin)
@@ -96,7 +131,7 @@ void Pin::transInfo(Pin* pin)
 {
     _x = pin->getX();
     _y = pin->getY();
-    _name = pin->getName();
+    _name = pin->getNameId();
     _type = pin->getType();
 }
 
@@ -109,6 +144,27 @@ void Pin::initArrivalTime()
     _initCriticalArrivalTime = _currCriticalArrivalTime;
 }
 
+/*
+Arrival time of a path from a previous stage pin at the current placement, the wires between the gates count
+*/
+double Pin::pathArrivalTime(size_t index) const
+{
+    const std::vector<Pin*>& path = _pathToPrevStagePins.at(index);
+    double arrival_time = 0;
+    for (size_t j = 0; j+1 < path.size(); j+=2)
+    {
+        Pin* curPin = path.at(j);
+        Pin* prevPin = path.at(j+1);
+        arrival_time += abs(curPin->getGlobalX() - prevPin->getGlobalX()) + abs(curPin->getGlobalY() - prevPin->getGlobalY());
+    }
+    arrival_time *= DISP_DELAY;
+    if (path.back()->getType() == PinType::FF_Q)
+    {
+        arrival_time += path.back()->getCell()->getQDelay();
+    }
+    return arrival_time;
+}
+
 /*
 Reset the arrival time of all paths from previous stage pins to this pin
 */
@@ -123,20 +179,7 @@ void Pin::resetArrivalTime(bool check)
     const size_t numPaths = _prevStagePins.size();
     for (size_t i = 0; i < numPaths; i++)
     {
-        std::vector<Pin*> path = _pathToPrevStagePins.at(i);
-        double arrival_time = 0;
-        for (size_t j = 0; j+1 < path.size(); j+=2)
-        {
-            Pin* curPin = path.at(j);
-            Pin* prevPin = path.at(j+1);
-            arrival_time += abs(curPin->getGlobalX() - prevPin->getGlobalX()) + abs(curPin->getGlobalY() - prevPin->getGlobalY());
-        }
-        arrival_time *= DISP_DELAY;
-        if (path.back()->getType() == PinType::FF_Q)
-        {
-            arrival_time += path.back()->getCell()->getQDelay();
-        }
-        _arrivalTimes.push_back(arrival_time);
+        _arrivalTimes.push_back(pathArrivalTime(i));
     }
     _currCriticalArrivalTime = 0;
     for (size_t i = 0; i < _arrivalTimes.size(); i++)
@@ -174,6 +217,16 @@ void Pin::resetArrivalTime(bool check)
     }
 }
 
+/*
+Arrival times of a trial, a per-thread copy so trials from many threads need no allocation
+*/
+static std::vector<double>& trialArrivalTimes(const std::vector<double>& arrivalTimes)
+{
+    static thread_local std::vector<double> scratch;
+    scratch.assign(arrivalTimes.begin(), arrivalTimes.end());
+    return scratch;
+}
+
 /*
 Calculate the slack of this pin after a previous stage pin is moved, no update
 Return the calculated slack
@@ -185,52 +238,51 @@ double Pin::calSlack(Pin* movedPrevStagePin, int sourceX, int sourceY, int targe
         std::cerr << "Error: only D pin can update slack" << std::endl;
         return _slack;
     }
-    if (_arrivalTimes.size() == 0)
+    const std::vector<size_t>* indexList = getPathIndex(movedPrevStagePin);
+    if (_arrivalTimes.size() == 0 || indexList == nullptr)
     {
         return _slack;
     }
-    std::vector<double>* tempArrivalTimes = (update) ? &_arrivalTimes : new std::vector<double>(_arrivalTimes);
+    HOTPATH_COUNT(SLACK_CALLS);
+    HOTPATH_ADD(SLACK_PATH_INDICES, indexList->size());
+    std::vector<double>& tempArrivalTimes = (update) ? _arrivalTimes : trialArrivalTimes(_arrivalTimes);
     // update the arrival time and re-sort the critical index
     const double old_critical_arrival_time = _currCriticalArrivalTime;
-    double* new_critical_arrival_time = (update) ? &_currCriticalArrivalTime : new double(_currCriticalArrivalTime);
-    size_t* new_critical_index = (update) ? &_currCriticalIndex : new size_t(_currCriticalIndex);
-    std::vector<size_t>* indexList = getPathIndex(movedPrevStagePin);
+    double new_critical_arrival_time = _currCriticalArrivalTime;
+    size_t new_critical_index = _currCriticalIndex;
     for (size_t index : *indexList)
     {
-        std::vector<Pin*> path = _pathToPrevStagePins.at(index);
+        const std::vector<Pin*>& path = _pathToPrevStagePins.at(index);
         Pin* secondLastPin = path.at(path.size()-2);
         const int secondLastPinX = secondLastPin->getGlobalX();
         const int secondLastPinY = secondLastPin->getGlobalY();
         const double diff_arrival_time = (abs(sourceX - secondLastPinX) + abs(sourceY - secondLastPinY) - abs(targetX - secondLastPinX) - abs(targetY - secondLastPinY)) * DISP_DELAY;
-        tempArrivalTimes->at(index) -= diff_arrival_time;
-        if (tempArrivalTimes->at(index) > *new_critical_arrival_time)
+        tempArrivalTimes.at(index) -= diff_arrival_time;
+        if (tempArrivalTimes.at(index) > new_critical_arrival_time)
         {
-            *new_critical_arrival_time = tempArrivalTimes->at(index);
-            *new_critical_index = index;
+            new_critical_arrival_time = tempArrivalTimes.at(index);
+            new_critical_index = index;
         }
-        else if (index == *new_critical_index && tempArrivalTimes->at(index) < *new_critical_arrival_time)
+        else if (index == new_critical_index && tempArrivalTimes.at(index) < new_critical_arrival_time)
         {
-            *new_critical_arrival_time = tempArrivalTimes->at(index);
-            for (size_t i = 0; i < tempArrivalTimes->size(); i++)
+            new_critical_arrival_time = tempArrivalTimes.at(index);
+            HOTPATH_COUNT(SLACK_RESCANS);
+            for (size_t i = 0; i < tempArrivalTimes.size(); i++)
             {
-                if (tempArrivalTimes->at(i) > *new_critical_arrival_time)
+                if (tempArrivalTimes.at(i) > new_critical_arrival_time)
                 {
-                    *new_critical_arrival_time = tempArrivalTimes->at(i);
-                    *new_critical_index = i;
+                    new_critical_arrival_time = tempArrivalTimes.at(i);
+                    new_critical_index = i;
                 }
             }
         }
     }
-    const double new_slack = _slack + (old_critical_arrival_time - *new_critical_arrival_time);
+    const double new_slack = _slack + (old_critical_arrival_time - new_critical_arrival_time);
     if (update)
     {
         _slack = new_slack;
-    }
-    else
-    {
-        delete tempArrivalTimes;
-        delete new_critical_arrival_time;
-        delete new_critical_index;
+        _currCriticalArrivalTime = new_critical_arrival_time;
+        _currCriticalIndex = new_critical_index;
     }
     return new_slack;
 }
@@ -246,46 +298,45 @@ double Pin::calSlackQ(Pin* changeQPin, double diffQDelay, bool update)
         std::cerr << "Error: only D pin can update slack" << std::endl;
         return _slack;
     }
-    if (_arrivalTimes.size() == 0)
+    const std::vector<size_t>* indexList = getPathIndex(changeQPin);
+    if (_arrivalTimes.size() == 0 || indexList == nullptr)
     {
         return _slack;
     }
-    std::vector<double>* tempArrivalTimes = (update) ? &_arrivalTimes : new std::vector<double>(_arrivalTimes);
+    HOTPATH_COUNT(SLACK_CALLS);
+    HOTPATH_ADD(SLACK_PATH_INDICES, indexList->size());
+    std::vector<double>& tempArrivalTimes = (update) ? _arrivalTimes : trialArrivalTimes(_arrivalTimes);
     const double old_arrival_time = _currCriticalArrivalTime;
-    double* new_arrival_time = (update) ? &_currCriticalArrivalTime : new double(_currCriticalArrivalTime);
-    size_t* new_critical_index = (update) ? &_currCriticalIndex : new size_t(_currCriticalIndex);
-    std::vector<size_t>* indexList = getPathIndex(changeQPin);
+    double new_arrival_time = _currCriticalArrivalTime;
+    size_t new_critical_index = _currCriticalIndex;
     for (size_t index : *indexList)
     {
-        tempArrivalTimes->at(index) += diffQDelay;
-        if (tempArrivalTimes->at(index) > *new_arrival_time)
+        tempArrivalTimes.at(index) += diffQDelay;
+        if (tempArrivalTimes.at(index) > new_arrival_time)
         {
-            *new_arrival_time = tempArrivalTimes->at(index);
-            *new_critical_index = index;
+            new_arrival_time = tempArrivalTimes.at(index);
+            new_critical_index = index;
         }
-        else if (index == *new_critical_index && tempArrivalTimes->at(index) < *new_arrival_time)
+        else if (index == new_critical_index && tempArrivalTimes.at(index) < new_arrival_time)
         {
-            *new_arrival_time = tempArrivalTimes->at(index);
-            for (size_t i = 0; i < tempArrivalTimes->size(); i++)
+            new_arrival_time = tempArrivalTimes.at(index);
+            HOTPATH_COUNT(SLACK_RESCANS);
+            for (size_t i = 0; i < tempArrivalTimes.size(); i++)
             {
-                if (tempArrivalTimes->at(i) > *new_arrival_time)
+                if (tempArrivalTimes.at(i) > new_arrival_time)
                 {
-                    *new_arrival_time = tempArrivalTimes->at(i);
-                    *new_critical_index = i;
+                    new_arrival_time = tempArrivalTimes.at(i);
+                    new_critical_index = i;
                 }
             }
         }
     }
-    const double new_slack = _slack + (old_arrival_time - *new_arrival_time);
+    const double new_slack = _slack + (old_arrival_time - new_arrival_time);
     if (update)
     {
         _slack = new_slack;
-    }
-    else
-    {
-        delete tempArrivalTimes;
-        delete new_arrival_time;
-        delete new_critical_index;
+        _currCriticalArrivalTime = new_arrival_time;
+        _currCriticalIndex = new_critical_index;
     }
     return new_slack;
 }
@@ -340,6 +391,23 @@ void Pin::resetSlack(bool check)
     }
 }
 
+/*
+Slack of this pin recomputed from its paths at the current placement, the same as resetSlack without changing the pin
+*/
+double Pin::recomputeSlack() const
+{
+    if (_arrivalTimes.size() == 0)
+    {
+        return _initSlack;
+    }
+    double critical_arrival_time = 0;
+    for (size_t i = 0; i < _prevStagePins.size(); i++)
+    {
+        critical_arrival_time = std::max(critical_arrival_time, pathArrivalTime(i));
+    }
+    return _initSlack + (_initCriticalArrivalTime - critical_arrival_time);
+}
+
 void Pin::initPathMaps()
 {
     for (size_t i = 0; i < _pathToPrevStagePins.size(); i++)
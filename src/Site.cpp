@@ -1,5 +1,6 @@
 #include <queue>
 #include <utility>
+#include <functional>
 #include "Site.h"
 #include "param.h"
 #include "Solver.h"
@@ -322,4 +323,148 @@ bool SiteMap::onSite(int x, int y)
         return false;
     }
     return true;
+}
+
+SiteRingIterator::SiteRingIterator(SiteMap* siteMap)
+{
+    _siteMap = siteMap;
+    _ring = 0;
+    _maxRing = -1;
+}
+
+/*
+Start a new walk from (x, y) over the sites fully covered by the block, same sites as SiteMap::getSitesInBlock()
+*/
+void SiteRingIterator::reset(int x, int y, int leftDownX, int leftDownY, int rightUpX, int rightUpY)
+{
+    _x = x;
+    _y = y;
+    _ring = -1;
+    _maxRing = -1;
+    _heap.clear();
+    _ordered.clear();
+    _c0.clear();
+    _colLo.clear();
+    _colHi.clear();
+    if (leftDownX < DIE_LOW_LEFT_X || leftDownY < DIE_LOW_LEFT_Y || rightUpX > DIE_UP_RIGHT_X || rightUpY > DIE_UP_RIGHT_Y)
+    {
+        std::cerr << "Error: SiteRingIterator::reset() - out of die boundary" << std::endl;
+        return;
+    }
+    const std::vector<PlacementRows>& rows = _siteMap->_placementRows;
+    _rowLo = _siteMap->getFirstLargerRow(leftDownY);
+    _rowHi = _siteMap->getFirstLargerRow(rightUpY);
+    if (_rowLo >= _rowHi)
+    {
+        return;
+    }
+    if (y < DIE_LOW_LEFT_Y || y > DIE_UP_RIGHT_Y)
+    {
+        _r0 = y < DIE_LOW_LEFT_Y ? _rowLo : _rowHi - 1;
+    }
+    else
+    {
+        _r0 = std::min(std::max(_siteMap->getFirstLargerRow(y), _rowLo), _rowHi - 1);
+    }
+    _maxRing = std::max(_r0 - _rowLo, _rowHi - 1 - _r0);
+    _minSiteWidth = INT_MAX;
+    for (int row = _rowLo; row < _rowHi; row++)
+    {
+        const int colLo = _siteMap->getFirstLargerColInRow(row, leftDownX);
+        const int colHi = std::min(_siteMap->getFirstLargerColInRow(row, rightUpX), int(_siteMap->_sites[row].size()) - 1);
+        // the column at or left of x, so the column k steps away is at least (k-1) site widths from x
+        int c0 = (x - rows[row].startX) / rows[row].siteWidth;
+        if (x < rows[row].startX)
+        {
+            c0 = colLo;
+        }
+        c0 = std::min(std::max(c0, colLo), std::max(colHi, colLo));
+        _c0.push_back(c0);
+        _colLo.push_back(colLo);
+        _colHi.push_back(colHi);
+        if (colLo <= colHi)
+        {
+            _maxRing = std::max(_maxRing, std::max(c0 - colLo, colHi - c0));
+        }
+        _minSiteWidth = std::min(_minSiteWidth, rows[row].siteWidth);
+    }
+}
+
+/*
+Get the i-th nearest site, nullptr if the block has fewer sites
+*/
+Site* SiteRingIterator::at(size_t i)
+{
+    while (_ordered.size() <= i)
+    {
+        if (!_heap.empty() && (_ring >= _maxRing || _heap.front().dist <= ringLowerBound(_ring + 1)))
+        {
+            std::pop_heap(_heap.begin(), _heap.end(), std::greater<Entry>());
+            const Entry& e = _heap.back();
+            _ordered.push_back(_siteMap->_sites[e.row][e.col]);
+            _heap.pop_back();
+        }
+        else if (_ring < _maxRing)
+        {
+            openRing(++_ring);
+        }
+        else
+        {
+            return nullptr;
+        }
+    }
+    return _ordered[i];
+}
+
+/*
+Lower bound of the distance from (x, y) to any site in ring or outside it
+*/
+int SiteRingIterator::ringLowerBound(int ring)
+{
+    const std::vector<PlacementRows>& rows = _siteMap->_placementRows;
+    int boundY = INT_MAX;
+    if (_r0 - ring >= _rowLo)
+    {
+        boundY = std::min(boundY, abs(rows[_r0 - ring].startY - _y));
+    }
+    if (_r0 + ring < _rowHi)
+    {
+        boundY = std::min(boundY, abs(rows[_r0 + ring].startY - _y));
+    }
+    const int boundX = std::max(ring - 1, 0) * _minSiteWidth;
+    return std::min(boundX, boundY);
+}
+
+void SiteRingIterator::openRing(int ring)
+{
+    for (int row = std::max(_r0 - ring, _rowLo); row <= std::min(_r0 + ring, _rowHi - 1); row++)
+    {
+        const int idx = row - _rowLo;
+        const int c0 = _c0[idx];
+        if (abs(row - _r0) == ring)
+        {
+            for (int col = std::max(c0 - ring, _colLo[idx]); col <= std::min(c0 + ring, _colHi[idx]); col++)
+            {
+                push(row, col);
+            }
+        }
+        else
+        {
+            if (c0 - ring >= _colLo[idx] && c0 - ring <= _colHi[idx])
+            {
+                push(row, c0 - ring);
+            }
+            if (ring > 0 && c0 + ring >= _colLo[idx] && c0 + ring <= _colHi[idx])
+            {
+                push(row, c0 + ring);
+            }
+        }
+    }
+}
+
+void SiteRingIterator::push(int row, int col)
+{
+    Site* site = _siteMap->_sites[row][col];
+    _heap.push_back(Entry{abs(site->getX() - _x) + abs(site->getY() - _y), row, col});
+    std::push_heap(_heap.begin(), _heap.end(), std::greater<Entry>());
 }
\ No newline at end of file
@@ -6,9 +6,16 @@
 #include "Site.h"
 #include "Bin.h"
 #include "LegalPlacer.h"
+#include "GlobalPlacer.h"
+#include "OutputBuffer.h"
+#include "Trace.h"
+#include "HotPath.h"
+#include "Evaluator.h"
+#include "ThreadConfig.h"
+#include <sys/resource.h>
+#include <random>
 #ifdef _OPENMP
 #include <omp.h>
-const int NUM_THREADS = 4;
 #endif
 
 // cost metrics
@@ -28,8 +35,6 @@ double BIN_MAX_UTIL;
 // Delay info
 double DISP_DELAY;
 
-const std::string DUMB_CELL_NAME = "du_mb";
-
 std::string toLower(std::string str)
 {
     transform(str.begin(), str.end(), str.begin(), ::tolower);
@@ -39,11 +44,14 @@ std::string toLower(std::string str)
 Solver::Solver()
 {
     _legalizer = new LegalPlacer(this);
+    _globalPlacer = new GlobalPlacer(this);
 }
 
 Solver::~Solver()
 {
     delete _legalizer;
+    delete _globalPlacer;
+    delete _verifier;
     for(auto ff : _ffs)
     {
         ff->deletePins();
@@ -76,6 +84,7 @@ Solver::~Solver()
 
 void Solver::parse_input(std::string filename)
 {
+    TRACE_SCOPE("parse_input");
     using namespace std;
     ifstream in(filename);
     if(!in.good())
@@ -136,6 +145,7 @@ void Solver::parse_input(std::string filename)
             // sort the pins by name
             sort(ff->inputPins.begin(), ff->inputPins.end(), [](Pin* a, Pin* b) -> bool { return a->getName() < b->getName(); });
             sort(ff->outputPins.begin(), ff->outputPins.end(), [](Pin* a, Pin* b) -> bool { return a->getName() < b->getName(); });
+            ff->indexPins();
             // set fanout of input pins to output pins
             _ffsLibList.push_back(ff);
             _ffsLibMap[name] = ff;
@@ -156,6 +166,7 @@ void Solver::parse_input(std::string filename)
                     comb->outputPins.push_back(new Pin(PinType::GATE_OUT, x, y, pinName, nullptr));
                 }
             }
+            comb->indexPins();
             _combsLibList.push_back(comb);
             _combsLibMap[name] = comb;
         }else{
@@ -391,82 +402,337 @@ void Solver::parse_input(std::string filename)
     in.close();
 }
 
+/*
+Move FFs to the best sites near them, sweep after sweep.
+The first sweep visits every FF, later sweeps only the FFs moved in the last sweep and their timing neighbours.
+Stop when a sweep gains less than FD_MIN_REL_GAIN of the cost, the worklist is empty or after FD_MAX_SWEEPS.
+With _fdColoring, FFs of a sweep are colored so that FFs of one color share no timing neighbour and no search window,
+the FFs of a color are evaluated in parallel and moved serially in _ffs order.
+*/
 void Solver::iterativePlacementLegal()
 {
     // HYPER
     int searchDistance;
-    if (_siteMap->getSites().size() == 0)
+    std::vector<Site*> sites = _siteMap->getSites();
+    if (sites.size() == 0)
     {
         searchDistance = 600;
     }
     else
     {
-        searchDistance = std::max(_siteMap->getSites()[0]->getHeight(), _siteMap->getSites()[0]->getWidth()) * 2;
+        searchDistance = std::max(sites[0]->getHeight(), sites[0]->getWidth()) * FD_SEARCH_FACTOR;
     }
-    for(size_t i = 0; i<_ffs.size();i++)
-    {
-        FF* ff = _ffs[i];
-        int leftDownX = std::max(ff->getX() - searchDistance, DIE_LOW_LEFT_X);
-        int leftDownY = std::max(ff->getY() - searchDistance, DIE_LOW_LEFT_Y);
-        int rightUpX = std::min(ff->getX() + searchDistance, DIE_UP_RIGHT_X);
-        int rightUpY = std::min(ff->getY() + searchDistance, DIE_UP_RIGHT_Y);
-        std::vector<Site*> nearSites = _siteMap->getSitesInBlock(leftDownX, leftDownY, rightUpX, rightUpY);
-        double cost_min = 0;
-        int best_site = -1;
 
-        #pragma omp parallel for num_threads(NUM_THREADS)
-            for(size_t j = 0; j < nearSites.size(); j++)
-            {   
-                if(!placeable(ff, nearSites[j]->getX(), nearSites[j]->getY()))
+    std::unordered_map<Cell*, size_t> ffIndex;
+    for (size_t i = 0; i < _ffs.size(); i++)
+    {
+        ffIndex[_ffs[i]] = i;
+    }
+    const double startCost = std::abs(_currCost);
+    std::vector<FF*> worklist = _ffs;
+    std::vector<char> queued(_ffs.size());
+    for (int sweep = 0; sweep < FD_MAX_SWEEPS && !worklist.empty() && !timeUp(); sweep++)
+    {
+        double gain = 0;
+        std::fill(queued.begin(), queued.end(), 0);
+        auto queueFF = [&](Cell* cell) {
+            if (cell == nullptr || cell->getCellType() != CellType::FF)
+                return;
+            auto it = ffIndex.find(cell);
+            if (it != ffIndex.end())
+            {
+                queued[it->second] = 1;
+            }
+        };
+        auto commitMove = [&](FF* ff, int x, int y, double cost) {
+            const int original_x = ff->getX();
+            const int original_y = ff->getY();
+            moveCell(ff, x, y);
+            calCostMoveFF(ff, original_x, original_y, x, y, true);
+            gain -= cost;
+            // the neighbours only feel the move through negative slacks
+            queueFF(ff);
+            for (auto inPin : ff->getInputPins())
+            {
+                if (inPin->getSlack() >= 0)
                     continue;
-                int original_x = ff->getX();
-                int original_y = ff->getY();
-                int trial_x = nearSites[j]->getX();
-                int trial_y = nearSites[j]->getY();
-                
-                // Bins cost difference when add and remove the cell
-                double binCost = _binMap->moveCell(ff, trial_x, trial_y, true);
-                double slackCost = calCostMoveFF(ff, original_x, original_y, trial_x, trial_y, false);
-
-                double cost = slackCost + binCost;
-                #pragma omp critical
+                for (auto prevPin : inPin->getPrevStagePins())
+                {
+                    queueFF(prevPin->getCell());
+                }
+            }
+            for (auto outPin : ff->getOutputPins())
+            {
+                for (auto nextPin : outPin->getNextStagePins())
                 {
-                    if(cost < cost_min)
+                    if (nextPin->getType() == PinType::FF_D && nextPin->getSlack() < 0)
                     {
-                        cost_min = cost;
-                        best_site = j;
+                        queueFF(nextPin->getCell());
                     }
                 }
             }
-        
-        if(best_site != -1)
+        };
+
+        if (!_fdColoring)
         {
-            const int original_x = ff->getX();
-            const int original_y = ff->getY();
-            moveCell(ff, nearSites[best_site]->getX(), nearSites[best_site]->getY());
-            calCostMoveFF(ff, original_x, original_y, nearSites[best_site]->getX(), nearSites[best_site]->getY(), true);
+            for (auto ff : worklist)
+            {
+                int bestX, bestY;
+                double bestCost;
+                if(findBestFFMove(ff, searchDistance, bestX, bestY, bestCost))
+                {
+                    commitMove(ff, bestX, bestY, bestCost);
+                }
+            }
+        }
+        else
+        {
+            std::vector<std::vector<FF*>> colors = colorFFsForPlacement(worklist, ffIndex, searchDistance);
+            for (auto& colorFFs : colors)
+            {
+                if (timeUp())
+                    break;
+                std::vector<int> bestX(colorFFs.size()), bestY(colorFFs.size());
+                std::vector<double> bestCost(colorFFs.size());
+                std::vector<char> found(colorFFs.size());
+                #ifdef _OPENMP
+                #pragma omp parallel for schedule(runtime) num_threads(ThreadConfig::threads())
+                #endif
+                for (size_t i = 0; i < colorFFs.size(); i++)
+                {
+                    TRACE_SCOPE("findBestFFMove");
+                    found[i] = findBestFFMove(colorFFs[i], searchDistance, bestX[i], bestY[i], bestCost[i]);
+                }
+                for (size_t i = 0; i < colorFFs.size(); i++)
+                {
+                    if (!found[i] || !placeable(colorFFs[i], bestX[i], bestY[i]))
+                        continue;
+                    commitMove(colorFFs[i], bestX[i], bestY[i], bestCost[i]);
+                }
+            }
+        }
+
+        worklist.clear();
+        for (size_t i = 0; i < _ffs.size(); i++)
+        {
+            if (queued[i])
+            {
+                worklist.push_back(_ffs[i]);
+            }
+        }
+        if (gain < FD_MIN_REL_GAIN * startCost)
+        {
+            break;
         }
     }
 }
 
-double Solver::calCost()
+/*
+Find the site near ff with the lowest negative cost difference (bestCost), return false if no site improves the cost.
+The slack cost is convex in the FF position, so subgradient * move + bin cost of removing the FF is a lower bound of the cost.
+Sites are evaluated in order of the bound and the search stops once the bound cannot beat the best cost.
+*/
+bool Solver::findBestFFMove(FF* ff, int searchDistance, int& bestX, int& bestY, double& bestCost)
 {
-    std::cout<<"--- Calculating cost ---\n";
-    double tns = 0.0;
-    double power = 0.0;
-    double area = 0.0;
-    int numOfBinsViolated = _binMap->getNumOverMaxUtilBins();
+    int leftDownX = std::max(ff->getX() - searchDistance, DIE_LOW_LEFT_X);
+    int leftDownY = std::max(ff->getY() - searchDistance, DIE_LOW_LEFT_Y);
+    int rightUpX = std::min(ff->getX() + searchDistance, DIE_UP_RIGHT_X);
+    int rightUpY = std::min(ff->getY() + searchDistance, DIE_UP_RIGHT_Y);
+    std::vector<Site*> nearSites = _siteMap->getSitesInBlock(leftDownX, leftDownY, rightUpX, rightUpY);
+    const int original_x = ff->getX();
+    const int original_y = ff->getY();
+
+    double gradX, gradY;
+    calSlackSubgradient(ff, gradX, gradY);
+    const double binRemoveCost = _binMap->removeCell(ff, true);
+    std::vector<std::pair<double, size_t>> order;
+    order.reserve(nearSites.size());
+    for(size_t j = 0; j < nearSites.size(); j++)
+    {
+        const double bound = gradX * (nearSites[j]->getX() - original_x) + gradY * (nearSites[j]->getY() - original_y) + binRemoveCost;
+        order.emplace_back(bound, j);
+    }
+    std::sort(order.begin(), order.end());
+
+    double cost_min = 0;
+    int best_site = -1;
+    for(auto& candidate : order)
+    {
+        if(candidate.first >= cost_min)
+            break;
+        const size_t j = candidate.second;
+        int trial_x = nearSites[j]->getX();
+        int trial_y = nearSites[j]->getY();
+        if(!placeable(ff, trial_x, trial_y))
+            continue;
+
+        // Bins cost difference when add and remove the cell
+        double binCost = _binMap->moveCell(ff, trial_x, trial_y, true);
+        double slackCost = calCostMoveFF(ff, original_x, original_y, trial_x, trial_y, false);
+
+        double cost = slackCost + binCost;
+        if(cost < cost_min)
+        {
+            cost_min = cost;
+            best_site = j;
+        }
+    }
+
+    if(best_site == -1)
+        return false;
+    bestX = nearSites[best_site]->getX();
+    bestY = nearSites[best_site]->getY();
+    bestCost = cost_min;
+    return true;
+}
+
+/*
+Subgradient of the slack cost of moving ff, only pins with negative slack contribute.
+D pins pull toward their fanin, Q pins pull toward the last pin of the next stage paths they are critical on.
+*/
+void Solver::calSlackSubgradient(FF* ff, double& gradX, double& gradY)
+{
+    gradX = 0;
+    gradY = 0;
+    const double weight = ALPHA * DISP_DELAY;
+    auto sign = [](int v) -> int { return (v > 0) - (v < 0); };
+    for (auto inPin : ff->getInputPins())
+    {
+        Pin* faninPin = inPin->getFaninPin();
+        if (faninPin == nullptr || faninPin->getCell() == ff || inPin->getSlack() >= 0)
+            continue;
+        gradX += weight * sign(inPin->getGlobalX() - faninPin->getGlobalX());
+        gradY += weight * sign(inPin->getGlobalY() - faninPin->getGlobalY());
+    }
+    for (auto outPin : ff->getOutputPins())
+    {
+        for (auto nextStagePin : outPin->getNextStagePins())
+        {
+            if (nextStagePin->getType() != PinType::FF_D || nextStagePin->getSlack() >= 0)
+                continue;
+            if (nextStagePin->getCell() == ff && nextStagePin->getFaninPin() == outPin)
+                continue;
+            const size_t critical = nextStagePin->getCriticalIndex();
+            const std::vector<size_t>* indexList = nextStagePin->getPathIndex(outPin);
+            if (indexList == nullptr || std::find(indexList->begin(), indexList->end(), critical) == indexList->end())
+                continue;
+            const std::vector<Pin*>& path = nextStagePin->getPathToPrevStagePins(critical);
+            Pin* secondLastPin = path.at(path.size()-2);
+            gradX += weight * sign(outPin->getGlobalX() - secondLastPin->getGlobalX());
+            gradY += weight * sign(outPin->getGlobalY() - secondLastPin->getGlobalY());
+        }
+    }
+}
+
+/*
+Greedy coloring of ffs for the parallel placement, ffIndex maps every FF in _ffs to its index.
+An FF claims itself, its prev and next stage FFs (timing), and the 3x3 grid cells around it (space),
+the grid is as wide as the reach of one move so FFs two cells apart never touch the same bins or sites.
+*/
+std::vector<std::vector<FF*>> Solver::colorFFsForPlacement(const std::vector<FF*>& ffs, const std::unordered_map<Cell*, size_t>& ffIndex, int searchDistance)
+{
+    int maxDim = 0;
+    for (auto lib : _ffsLibList)
+    {
+        maxDim = std::max(maxDim, std::max(lib->width, lib->height));
+    }
+    const int gridSize = searchDistance + maxDim + std::max(BIN_WIDTH, BIN_HEIGHT);
+    const int numGridX = (DIE_UP_RIGHT_X - DIE_LOW_LEFT_X) / gridSize + 1;
+    const int numGridY = (DIE_UP_RIGHT_Y - DIE_LOW_LEFT_Y) / gridSize + 1;
+
+    // colors used by the FFs claiming each resource, FFs first and then grid cells
+    std::vector<std::vector<int>> resourceColors(_ffs.size() + numGridX * numGridY);
+    std::vector<std::vector<FF*>> colors;
+    std::vector<size_t> resources;
+    std::vector<char> forbidden;
+    for (auto ff : ffs)
+    {
+        resources.clear();
+        resources.push_back(ffIndex.at(ff));
+        auto claimCell = [&](Cell* cell) {
+            if (cell == nullptr || cell->getCellType() != CellType::FF)
+                return;
+            auto it = ffIndex.find(cell);
+            if (it != ffIndex.end())
+            {
+                resources.push_back(it->second);
+            }
+        };
+        for (auto inPin : ff->getInputPins())
+        {
+            for (auto prevPin : inPin->getPrevStagePins())
+            {
+                claimCell(prevPin->getCell());
+            }
+        }
+        for (auto outPin : ff->getOutputPins())
+        {
+            for (auto nextPin : outPin->getNextStagePins())
+            {
+                claimCell(nextPin->getCell());
+            }
+        }
+        const int gx = std::min(std::max((ff->getX() - DIE_LOW_LEFT_X) / gridSize, 0), numGridX - 1);
+        const int gy = std::min(std::max((ff->getY() - DIE_LOW_LEFT_Y) / gridSize, 0), numGridY - 1);
+        for (int y = std::max(gy - 1, 0); y <= std::min(gy + 1, numGridY - 1); y++)
+        {
+            for (int x = std::max(gx - 1, 0); x <= std::min(gx + 1, numGridX - 1); x++)
+            {
+                resources.push_back(_ffs.size() + y * numGridX + x);
+            }
+        }
+
+        forbidden.assign(colors.size() + 1, 0);
+        for (auto r : resources)
+        {
+            for (auto c : resourceColors[r])
+            {
+                forbidden[c] = 1;
+            }
+        }
+        int color = 0;
+        while (forbidden[color])
+        {
+            color++;
+        }
+        if (color == int(colors.size()))
+        {
+            colors.emplace_back();
+        }
+        colors[color].push_back(ff);
+        for (auto r : resources)
+        {
+            std::vector<int>& used = resourceColors[r];
+            if (std::find(used.begin(), used.end(), color) == used.end())
+            {
+                used.push_back(color);
+            }
+        }
+    }
+    return colors;
+}
+
+CostComponents Solver::calCostComponents()
+{
+    CostComponents c{0.0, 0.0, 0.0, _binMap->getNumOverMaxUtilBins()};
     for(auto ff : _ffs)
     {
-        tns += ff->getTotalNegativeSlack();
-        power += ff->getPower();
-        area += ff->getArea();
+        c.tns += ff->getTotalNegativeSlack();
+        c.power += ff->getPower();
+        c.area += ff->getArea();
     }
-    std::cout<<"TNS: "<<tns<<"\n";
-    std::cout<<"Power: "<<power<<"\n";
-    std::cout<<"Area: "<<area<<"\n";
-    std::cout<<"Num of bins violated: "<<numOfBinsViolated<<"\n";
-    double cost = ALPHA * tns + BETA * power + GAMMA * area + LAMBDA * numOfBinsViolated;
+    return c;
+}
+
+double Solver::calCost()
+{
+    std::cout<<"--- Calculating cost ---\n";
+    const CostComponents c = calCostComponents();
+    std::cout<<"TNS: "<<c.tns<<"\n";
+    std::cout<<"Power: "<<c.power<<"\n";
+    std::cout<<"Area: "<<c.area<<"\n";
+    std::cout<<"Num of bins violated: "<<c.bins<<"\n";
+    double cost = ALPHA * c.tns + BETA * c.power + GAMMA * c.area + LAMBDA * c.bins;
     return cost;
 }
 
@@ -520,16 +786,19 @@ Call before placing the cell if considering overlap
 */
 bool Solver::placeable(Cell* cell, int x,int y)
 {
+    _counters.placeableCalls++;
     // check the cell is on site
     if(!_siteMap->onSite(x, y))
     {
         // std::cerr << "Cell not placed on site: " << cell->getInstName() << std::endl;
+        HOTPATH_COUNT(PLACEABLE_REJECT_OFF_SITE);
         return false;
     }
     // check the cell in the die
     if(x < DIE_LOW_LEFT_X || x+cell->getWidth() > DIE_UP_RIGHT_X || y < DIE_LOW_LEFT_Y || y+cell->getHeight() > DIE_UP_RIGHT_Y)
     {
         // std::cerr << "Cell not in die: " << cell->getInstName() << std::endl;
+        HOTPATH_COUNT(PLACEABLE_REJECT_OUT_OF_DIE);
         return false;
     }
     // check the cell will not overlap with other cells in the bin
@@ -538,10 +807,11 @@ bool Solver::placeable(Cell* cell, int x,int y)
     {
         for(auto c: bin->getCells())
         {
-            if(c->getInstName() == DUMB_CELL_NAME || c == cell)
+            if(c->getInstNameId() == DUMB_CELL_ID || c == cell)
                 continue;
             if(isOverlap(x, y, cell, c))
             {
+                HOTPATH_COUNT(PLACEABLE_REJECT_OVERLAP);
                 return false;
             }
         }
@@ -555,16 +825,19 @@ Call before placing the cell if considering overlap
 */
 bool Solver::placeable(LibCell* libCell, int x, int y)
 {
+    _counters.placeableCalls++;
     // check the cell is on site
     if(!_siteMap->onSite(x, y))
     {
         // std::cerr << "Cell not placed on site: " << cell->getInstName() << std::endl;
+        HOTPATH_COUNT(PLACEABLE_REJECT_OFF_SITE);
         return false;
     }
     // check the cell in the die
     if(x < DIE_LOW_LEFT_X || x+libCell->width > DIE_UP_RIGHT_X || y < DIE_LOW_LEFT_Y || y+libCell->height > DIE_UP_RIGHT_Y)
     {
         // std::cerr << "Cell not in die: " << cell->getInstName() << std::endl;
+        HOTPATH_COUNT(PLACEABLE_REJECT_OUT_OF_DIE);
         return false;
     }
     // check the cell will not overlap with other cells in the bin
@@ -574,12 +847,13 @@ bool Solver::placeable(LibCell* libCell, int x, int y)
     {
         for(auto cell: bin->getCells())
         {
-            if(cell->getInstName() == DUMB_CELL_NAME)
+            if(cell->getInstNameId() == DUMB_CELL_ID)
             {
                 continue;
             }
             if(isOverlap(x, y, libCell->width, libCell->height, cell))
             {
+                HOTPATH_COUNT(PLACEABLE_REJECT_OVERLAP);
                 return false;
             }
         }
@@ -594,16 +868,19 @@ move_distance is the distance the cell need to move to avoid overlap in current
 */
 bool Solver::placeable(Cell* cell, int x, int y, int& move_distance)
 {
+    _counters.placeableCalls++;
     // check the cell is on site
     if(!_siteMap->onSite(x, y))
     {
         // std::cerr << "Cell not placed on site: " << cell->getInstName() << std::endl;
+        HOTPATH_COUNT(PLACEABLE_REJECT_OFF_SITE);
         return false;
     }
     // check the cell in the die
     if(x < DIE_LOW_LEFT_X || x+cell->getWidth() > DIE_UP_RIGHT_X || y < DIE_LOW_LEFT_Y || y+cell->getHeight() > DIE_UP_RIGHT_Y)
     {
         // std::cerr << "Cell not in die: " << cell->getInstName() << std::endl;
+        HOTPATH_COUNT(PLACEABLE_REJECT_OUT_OF_DIE);
         return false;
     }
     // check the cell will not overlap with other cells in the bin
@@ -614,7 +891,7 @@ bool Solver::placeable(Cell* cell, int x, int y, int& move_distance)
     {
         for(auto c: bin->getCells())
         {
-            if(c == cell || c->getInstName() == DUMB_CELL_NAME)
+            if(c == cell || c->getInstNameId() == DUMB_CELL_ID)
             {
                 continue;
             }
@@ -626,6 +903,10 @@ bool Solver::placeable(Cell* cell, int x, int y, int& move_distance)
         }
     }
     move_distance = move;
+    if (overlap)
+    {
+        HOTPATH_COUNT(PLACEABLE_REJECT_OVERLAP);
+    }
     return !overlap;
 }
 
@@ -758,6 +1039,11 @@ Update current cost after moving the ff
 */
 double Solver::calCostMoveFF(FF* movedFF, int sourceX, int sourceY, int targetX, int targetY, bool update)
 {
+    _counters.costEvals++;
+    if (update)
+    {
+        _counters.movesAccepted++;
+    }
     if (sourceX == targetX && sourceY == targetY)
     {
         return 0;
@@ -776,6 +1062,7 @@ double Solver::calCostMoveFF(FF* movedFF, int sourceX, int sourceY, int targetX,
 
 double Solver::calCostBankFF(FF* ff1, FF* ff2, LibCell* targetFF, int targetX, int targetY, bool update)
 {
+    _counters.costEvals++;
     double diff_cost = 0;
     diff_cost += (targetFF->power - ff1->getPower() - ff2->getPower()) * BETA;
     diff_cost += (targetFF->width * targetFF->height - ff1->getArea() - ff2->getArea()) * GAMMA;
@@ -868,6 +1155,7 @@ double Solver::calCostBankFF(FF* ff1, FF* ff2, LibCell* targetFF, int targetX, i
 
 double Solver::calCostDebankFF(FF* ff, LibCell* targetFF, std::vector<int>& targetX, std::vector<int>& targetY, bool update)
 {
+    _counters.costEvals++;
     std::vector<std::pair<Pin*, Pin*>> dqPairs = ff->getDQpairs();
     const int x = ff->getX();
     const int y = ff->getY();
@@ -905,7 +1193,7 @@ double Solver::calCostDebankFF(FF* ff, LibCell* targetFF, std::vector<int>& targ
         {
             // loop
             const double old_slack = d->getSlack();
-            const double diff_dist = abs(target_dx - target_qx) + abs(target_dx - target_qy) - abs(original_dx - original_qx) - abs(original_dy - original_qy);
+            const double diff_dist = abs(target_dx - target_qx) + abs(target_dy - target_qy) - abs(original_dx - original_qx) - abs(original_dy - original_qy);
             const double new_slack = old_slack - DISP_DELAY * diff_dist;
             if(update)
             {
@@ -951,14 +1239,18 @@ void Solver::deleteFF(FF* ff)
     delete ff;
 }
 
-void Solver::bankFFs(FF* ff1, FF* ff2, LibCell* targetFF, int x, int y)
+/*
+Bank ff1 and ff2 into targetFF at (x, y), the current cost will be updated
+Return the banked FF, nullptr if the FFs can not be banked
+*/
+FF* Solver::bankFFs(FF* ff1, FF* ff2, LibCell* targetFF, int x, int y)
 {
     if (ff1->getClkDomain() != ff2->getClkDomain())
     {
         std::cerr << "Error: Banking FFs in different clk domains" << std::endl;
         std::cerr << "FF1: " << ff1->getInstName() << " clk domain: " << ff1->getClkDomain() << std::endl;
         std::cerr << "FF2: " << ff2->getInstName() << " clk domain: " << ff2->getClkDomain() << std::endl;
-        return;
+        return nullptr;
     }
     removeCell(ff1);
     removeCell(ff2);
@@ -977,9 +1269,11 @@ void Solver::bankFFs(FF* ff1, FF* ff2, LibCell* targetFF, int x, int y)
     bankedFF->setClkDomain(ff1->getClkDomain());
     addFF(bankedFF);
     placeCell(bankedFF);
+    _counters.banks++;
     // free up old ffs
     deleteFF(ff1);
     deleteFF(ff2);
+    return bankedFF;
 }
 
 std::string Solver::makeUniqueName()
@@ -988,124 +1282,101 @@ std::string Solver::makeUniqueName()
     return newName;
 }
 
+/*
+Debank all FFs into one-bit FFs.
+The die is cut into tiles wide enough that the tiles of one color (2x2 coloring) never touch the same bins or sites.
+The tiles of a color are planned in parallel, each tile reserving its target sites in its own list,
+then the plans are committed serially so the timing updates and the new names stay deterministic.
+*/
 void Solver::debankAll()
 {
-    // TODO: speed up
     std::vector<LibCell*> oneBitFFs;
+    int maxLibDim = 0;
     for (auto ff : _ffsLibList)
     {
         if(ff->bit == 1)
         {
             oneBitFFs.push_back(ff);
         }
+        maxLibDim = std::max(maxLibDim, std::max(ff->width, ff->height));
     }
     // std::sort(oneBitFFs.begin(), oneBitFFs.end(), [](LibCell* a, LibCell* b) -> bool { return a->width * a->height < b->width * b->height; });
 
-    std::vector<FF*> debankedFFs;
+    // an FF reads and writes the die within its search distance plus a footprint around it, rounded out to bins
+    const int reach = 2 * maxLibDim + std::max(BIN_WIDTH, BIN_HEIGHT);
+    const int tileSize = std::max(2 * reach, 1);
+    const int numTilesX = (DIE_UP_RIGHT_X - DIE_LOW_LEFT_X) / tileSize + 1;
+    const int numTilesY = (DIE_UP_RIGHT_Y - DIE_LOW_LEFT_Y) / tileSize + 1;
+    // tiles of each color, FFs of each tile in the order of _ffs
+    std::vector<std::vector<std::vector<FF*>>> colorTiles(4);
+    std::vector<std::vector<FF*>> tiles(numTilesX * numTilesY);
     for (auto ff : _ffs)
     {
-        removeCell(ff);
-
-        std::vector<std::pair<Pin*, Pin*>> dqPairs = ff->getDQpairs();
-        Pin* clkPin = ff->getClkPin();
-        const int x = ff->getX();
-        const int y = ff->getY();
-        const int clkDomain = ff->getClkDomain();
+        const int tx = std::min(std::max((ff->getX() - DIE_LOW_LEFT_X) / tileSize, 0), numTilesX - 1);
+        const int ty = std::min(std::max((ff->getY() - DIE_LOW_LEFT_Y) / tileSize, 0), numTilesY - 1);
+        tiles[ty * numTilesX + tx].push_back(ff);
+    }
+    for (int ty = 0; ty < numTilesY; ty++)
+    {
+        for (int tx = 0; tx < numTilesX; tx++)
+        {
+            std::vector<FF*>& tile = tiles[ty * numTilesX + tx];
+            if (!tile.empty())
+                colorTiles[(ty % 2) * 2 + (tx % 2)].push_back(tile);
+        }
+    }
 
-        double minCost = 0;
-        LibCell* bestFF = ff->getLibCell();
-        std::vector<int> bestX = {x};
-        std::vector<int> bestY = {y};
+    std::vector<FF*> debankedFFs;
+    for (int color = 0; color < 4; color++)
+    {
+        std::vector<std::vector<FF*>>& colorTile = colorTiles[color];
+        std::vector<std::vector<DebankPlan>> plans(colorTile.size());
+        #ifdef _OPENMP
+        #pragma omp parallel for schedule(runtime) num_threads(ThreadConfig::threads())
+        #endif
+        for (size_t t = 0; t < colorTile.size(); t++)
+        {
+            TRACE_SCOPE("planDebankTile");
+            std::vector<Rect> reserved;
+            SiteRingIterator nearSites(_siteMap);
+            for (auto ff : colorTile[t])
+            {
+                removeCell(ff);
+                plans[t].push_back(planDebankFF(ff, oneBitFFs, nearSites, reserved));
+            }
+        }
 
-        #pragma omp parallel for num_threads(NUM_THREADS)
-            for(size_t i = 0; i < oneBitFFs.size(); i++)
+        for (auto& tilePlans : plans)
+        {
+            for (auto& plan : tilePlans)
             {
-                LibCell* oneBitFF = oneBitFFs[i];
-                std::vector<int> target_X, target_Y;
-                // HYPER
-                int searchDistance = std::max(ff->getWidth(), ff->getHeight());
-                
-                int leftDownX = std::max(ff->getX() - searchDistance, DIE_LOW_LEFT_X);
-                int leftDownY = std::max(ff->getY() - searchDistance, DIE_LOW_LEFT_Y);
-                int rightUpX = std::min(ff->getX() + searchDistance, DIE_UP_RIGHT_X);
-                int rightUpY = std::min(ff->getY() + searchDistance, DIE_UP_RIGHT_Y);
-                std::vector<Site*> nearSites = _siteMap->getSitesInBlock(leftDownX, leftDownY, rightUpX, rightUpY);
-                // sort the sites by distance
-                std::sort(nearSites.begin(), nearSites.end(), [ff](Site* a, Site* b) -> bool {
-                    return abs(a->getX()-ff->getX()) + abs(a->getY()-ff->getY()) < abs(b->getX()-ff->getX()) + abs(b->getY()-ff->getY());
-                });
-
-                int found = 0;
-                std::vector<Cell*> candidates;
-
-                for(size_t j = 0; j < nearSites.size(); j++)
-                {   
-                    if(!placeable(oneBitFF, nearSites[j]->getX(), nearSites[j]->getY()))
-                        continue;
-                    // check if overlap with other candidate FF
-                    bool overlap = false;
-                    for(auto candidate: candidates)
-                    {
-                        if(isOverlap(nearSites[j]->getX(), nearSites[j]->getY(), oneBitFF->width, oneBitFF->height, candidate))
-                        {
-                            overlap = true;
-                            break;
-                        }
-                    }
-                    if(overlap)
-                        continue;
-                    found++;
-                    target_X.push_back(nearSites[j]->getX());
-                    target_Y.push_back(nearSites[j]->getY());
-                    candidates.push_back(new Cell(nearSites[j]->getX(), nearSites[j]->getY(), DUMB_CELL_NAME, oneBitFF));
-                    if(found == ff->getBit())
-                        break;
-                }
-                
-                for(auto candidate: candidates)
+                FF* ff = plan.ff;
+                std::vector<std::pair<Pin*, Pin*>> dqPairs = ff->getDQpairs();
+                Pin* clkPin = ff->getClkPin();
+                const int clkDomain = ff->getClkDomain();
+                if(!plan.debank)
                 {
-                    if(candidate != nullptr)
-                        delete candidate;
-                }
-
-                if(found < ff->getBit())
+                    // no better FF found
+                    FF* cloneFF = new FF(ff->getX(), ff->getY(), makeUniqueName(), plan.targetFF, dqPairs, clkPin);
+                    cloneFF->setClkDomain(clkDomain);
+                    debankedFFs.push_back(cloneFF);
+                    placeCell(cloneFF);
+                    delete clkPin;
                     continue;
+                }
 
-                double costDiff = calCostDebankFF(ff, oneBitFF, target_X, target_Y, false);
+                calCostDebankFF(ff, plan.targetFF, plan.targetX, plan.targetY, true);
 
-                #pragma omp critical
+                for(size_t i=0;i<dqPairs.size();i++)
                 {
-                    if (costDiff < minCost)
-                    {
-                        minCost = costDiff;
-                        bestX = target_X;
-                        bestY = target_Y;
-                        bestFF = oneBitFF;
-                    }
+                    FF* newFF = new FF(plan.targetX[i], plan.targetY[i], makeUniqueName(), plan.targetFF, dqPairs[i], clkPin);
+                    newFF->setClkDomain(clkDomain);
+                    debankedFFs.push_back(newFF);
+                    placeCell(newFF);
                 }
+                delete clkPin;
             }
-
-        if(minCost == 0)
-        {
-            // no better FF found
-            FF* cloneFF = new FF(x, y, makeUniqueName(), bestFF, dqPairs, clkPin);
-            cloneFF->setClkDomain(clkDomain);
-            debankedFFs.push_back(cloneFF);
-            placeCell(cloneFF);
-            delete clkPin;
-            continue;
-        }
-
-        calCostDebankFF(ff, bestFF, bestX, bestY, true);
-
-        for(size_t i=0;i<dqPairs.size();i++)
-        {
-            FF* newFF = new FF(bestX[i], bestY[i], makeUniqueName(), bestFF, dqPairs[i], clkPin);
-            newFF->setClkDomain(clkDomain);
-            debankedFFs.push_back(newFF);
-            placeCell(newFF);
         }
-        delete clkPin;
     }
 
     for(size_t i=0;i<_ffs.size();i++)
@@ -1119,6 +1390,101 @@ void Solver::debankAll()
         addFF(ff);
     }
 }
+
+/*
+Choose the one-bit FF and the sites to debank the removed ff into, the chosen sites are appended to reserved.
+The timing is only read here, so plans of FFs in different tiles can be made in parallel.
+*/
+DebankPlan Solver::planDebankFF(FF* ff, const std::vector<LibCell*>& oneBitFFs, SiteRingIterator& nearSites, std::vector<Rect>& reserved)
+{
+    // HYPER
+    const int searchDistance = std::max(ff->getWidth(), ff->getHeight()) * DEBANK_SEARCH_FACTOR;
+    const int leftDownX = std::max(ff->getX() - searchDistance, DIE_LOW_LEFT_X);
+    const int leftDownY = std::max(ff->getY() - searchDistance, DIE_LOW_LEFT_Y);
+    const int rightUpX = std::min(ff->getX() + searchDistance, DIE_UP_RIGHT_X);
+    const int rightUpY = std::min(ff->getY() + searchDistance, DIE_UP_RIGHT_Y);
+    // the sites near ff are walked once and replayed for every lib
+    nearSites.reset(ff->getX(), ff->getY(), leftDownX, leftDownY, rightUpX, rightUpY);
+
+    DebankPlan plan;
+    plan.ff = ff;
+    plan.targetFF = ff->getLibCell();
+    plan.debank = false;
+
+    double minCost = 0;
+    for(size_t i = 0; i < oneBitFFs.size(); i++)
+    {
+        LibCell* oneBitFF = oneBitFFs[i];
+        std::vector<int> target_X, target_Y;
+        if(!findDebankSites(ff, oneBitFF, nearSites, reserved, target_X, target_Y))
+            continue;
+
+        double costDiff = calCostDebankFF(ff, oneBitFF, target_X, target_Y, false);
+        if (costDiff < minCost)
+        {
+            minCost = costDiff;
+            plan.targetX = target_X;
+            plan.targetY = target_Y;
+            plan.targetFF = oneBitFF;
+            plan.debank = true;
+        }
+    }
+
+    if(plan.debank)
+    {
+        for(size_t i = 0; i < plan.targetX.size(); i++)
+        {
+            reserved.push_back(Rect{plan.targetX[i], plan.targetY[i], plan.targetFF->width, plan.targetFF->height});
+        }
+    }
+    else
+    {
+        reserved.push_back(Rect{ff->getX(), ff->getY(), ff->getWidth(), ff->getHeight()});
+    }
+    return plan;
+}
+
+/*
+Find the nearest sites to place every bit of ff as oneBitFF, avoiding placed cells, the reserved rects and each other
+nearSites must be reset around ff
+*/
+bool Solver::findDebankSites(FF* ff, LibCell* oneBitFF, SiteRingIterator& nearSites, const std::vector<Rect>& reserved, std::vector<int>& targetX, std::vector<int>& targetY)
+{
+    auto overlapRect = [oneBitFF](int x, int y, const Rect& r) -> bool {
+        return x < r.x + r.w && x + oneBitFF->width > r.x && y < r.y + r.h && y + oneBitFF->height > r.y;
+    };
+
+    const int bits = ff->getBit();
+    for(size_t j = 0; Site* site = nearSites.at(j); j++)
+    {
+        const int x = site->getX();
+        const int y = site->getY();
+        if(!placeable(oneBitFF, x, y))
+            continue;
+        // check if overlap with reserved space or other chosen sites
+        bool overlap = false;
+        for(const Rect& r : reserved)
+        {
+            if(overlapRect(x, y, r))
+            {
+                overlap = true;
+                break;
+            }
+        }
+        for(size_t k = 0; !overlap && k < targetX.size(); k++)
+        {
+            overlap = overlapRect(x, y, Rect{targetX[k], targetY[k], oneBitFF->width, oneBitFF->height});
+        }
+        if(overlap)
+            continue;
+        targetX.push_back(x);
+        targetY.push_back(y);
+        if((int)targetX.size() == bits)
+            return true;
+    }
+    return false;
+}
+
 /*
 Calculate the cost difference given the old and new slack, the return value should be "added" to the current cost
 */
@@ -1140,166 +1506,352 @@ double Solver::calDiffCost(double oldSlack, double newSlack)
     return ALPHA * diff_neg_slack;
 }
 
+/*
+Run the phases in order. Without a time budget every phase runs once.
+With a time budget a phase is skipped when its estimated time does not fit in the remaining time,
+force-directed placement and banking are cut at the deadline, and banking and placement are repeated
+while time is left and they still improve the best cost.
+*/
 void Solver::solve()
 {
-    bool calTime = true;
-    auto start = std::chrono::high_resolution_clock::now();
-    auto start_solve_time = start;
-    auto end = std::chrono::high_resolution_clock::now();
+    if(_timeBudget <= 0)
+    {
+        _solveStart = std::chrono::steady_clock::now();
+    }
 
     std::cout<<"Alpha: "<<ALPHA<<" Beta: "<<BETA<<" Gamma: "<<GAMMA<<" Lambda: "<<LAMBDA<<"\n";
 
-    std::cout << "\nStart initial placement...\n";
-    init_placement();
-    _currCost = calCost();
-    _initCost = _currCost;
-    std::cout << "==> Initial cost: " << _initCost << "\n";
-
-    if(calTime)
+    runPhase("Initial", "", [this]() {
+        init_placement();
+        // the FFs may have been moved onto sites
+        resetSlack(false);
+        _currCost = calCost();
+        _initCost = _currCost;
+    });
+    runPhase("Debank", "debank", [this]() {
+        debankAll();
+        _currCost = calCost();
+    });
+    if(_ffs.size() >= size_t(GP_MIN_FFS))
     {
-        end = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<double> elapsed = end - start;
-        _stateTimes.push_back(elapsed.count());
-        std::cout << "Initialization time: " << elapsed.count() << "s" << std::endl;
-        start = std::chrono::high_resolution_clock::now();
+        runPhase("GlobalPlacement", "gp", [this]() {
+            _globalPlacer->place();
+        });
     }
+    runPhase("ForceDirected", "fd", [this]() { runForceDirected(); });
+    runPhase("Banking", "banking", [this]() { runBanking(); });
+    runPhase("ForceDirected2", "fd", [this]() { runForceDirected(); });
+    runPhase("Banking2", "banking", [this]() { runBanking(); });
+    runPhase("ForceDirected3", "fd", [this]() { runForceDirected(); });
 
-    bool legal = check();
-    std::cout << "Legal: " << legal << "\n";
-    if(!legal)
+    // spend the rest of the budget on more rounds
+    for(int round = 3; _timeBudget > 0; round++)
     {
-        _legalizer->legalize();
-        resetSlack(false);
-        _currCost = calCost();
+        const double prevBest = _bestCost;
+        if(!runPhase("Banking" + std::to_string(round), "banking", [this]() { runBanking(); }))
+            break;
+        if(!runPhase("ForceDirected" + std::to_string(round + 1), "fd", [this]() { runForceDirected(); }))
+            break;
+        if(prevBest - _bestCost < FD_MIN_REL_GAIN * std::abs(prevBest))
+            break;
     }
-    saveState("Initial");
 
-    std::cout << "\nStart to debank...\n";
-    debankAll();
-    _currCost = calCost();
-    std::cout << "==> Cost after debanking: " << _currCost << "\n";
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - _solveStart;
+    _stateTimes.push_back(elapsed.count());
+    std::cout << "Total solve time: " << elapsed.count() << "s" << std::endl;
+
+    std::cout << "\nCost after solving: " << _currCost << "\n";
+    std::cout << "Cost difference: " << _currCost - _initCost << "\n";
+    std::cout << "Cost difference percentage: " << (_currCost - _initCost) / _initCost * 100 << "%\n";
+}
+
+/*
+Set the wall-clock budget in seconds (<= 0 for no budget), counted from this call.
+With a budget, the best state is also written to checkpointFile whenever it improves.
+*/
+void Solver::setTimeBudget(double seconds, std::string checkpointFile)
+{
+    _solveStart = std::chrono::steady_clock::now();
+    _timeBudget = seconds;
+    _checkpointFile = checkpointFile;
+}
+
+/*
+Seconds left before the deadline of the budget, keeping time for the final check and writing the output
+*/
+double Solver::remainingTime() const
+{
+    if(_timeBudget <= 0)
+        return INFINITY;
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - _solveStart;
+    // HYPER
+    const double reserve = 2 * _dumpTime + _checkTime + 0.01 * _timeBudget;
+    return _timeBudget - elapsed.count() - reserve;
+}
+
+bool Solver::timeUp() const
+{
+    return remainingTime() <= 0;
+}
 
-    if(calTime)
+/*
+Run one phase, then legalize if needed and save the state.
+kind names the throughput estimate and the loop schedule of the phase (empty for a phase that always runs),
+return false if the phase is skipped for lack of time.
+*/
+bool Solver::runPhase(std::string name, std::string kind, std::function<void()> body)
+{
+    if(!kind.empty() && _timeBudget > 0)
     {
-        end = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<double> elapsed = end - start;
-        _stateTimes.push_back(elapsed.count());
-        std::cout << "Debanking time: " << elapsed.count() << "s" << std::endl;
-        start = std::chrono::high_resolution_clock::now();
+        if(_phaseRate.find(kind) == _phaseRate.end())
+        {
+            _phaseRate[kind] = (kind == "debank") ? EST_DEBANK_TIME_PER_FF : (kind == "gp") ? EST_GP_TIME_PER_FF : (kind == "fd") ? EST_FD_TIME_PER_FF : EST_BANKING_TIME_PER_FF;
+        }
+        const double estimate = _phaseRate[kind] * _ffs.size();
+        // force-directed placement and banking can be cut at the deadline, the others must finish
+        const bool truncatable = (kind == "fd" || kind == "banking");
+        const double needed = truncatable ? MIN_TRUNCATED_PHASE * estimate : estimate;
+        if(remainingTime() < needed)
+        {
+            std::cout << "\nSkip " << name << ": estimated " << estimate << "s, remaining " << remainingTime() << "s\n";
+            return false;
+        }
     }
 
-    legal = check();
-    std::cout << "Legal: " << legal << "\n";
-    if(!legal)
+    std::cout << "\nStart " << name << "...\n";
+    auto start = std::chrono::steady_clock::now();
+    const size_t numFFs = _ffs.size();
+    PhaseStats stats = startPhaseStats(name);
+    ThreadConfig::applySchedule(kind.empty() ? "default" : kind);
     {
-        _legalizer->legalize();
-        resetSlack(false);
-        _currCost = calCost();
+        TRACE_SCOPE(Trace::label(name));
+        body();
     }
-    saveState("Debank");
-
-    std::cout<<"\nStart to force directed placement...\n";
-    iterativePlacementLegal();
-    _currCost = calCost();
-    std::cout << "==> Cost after force directed placement: " << _currCost << "\n";
+    std::cout << "==> Cost after " << name << ": " << _currCost << "\n";
 
-    if(calTime)
+    auto checkStart = std::chrono::steady_clock::now();
+    bool legal;
     {
-        end = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<double> elapsed = end - start;
-        _stateTimes.push_back(elapsed.count());
-        std::cout << "Force directed placement time: " << elapsed.count() << "s" << std::endl;
-        start = std::chrono::high_resolution_clock::now();
+        TRACE_SCOPE("check");
+        legal = check();
     }
-
-    legal = check();
+    std::chrono::duration<double> checkElapsed = std::chrono::steady_clock::now() - checkStart;
+    _checkTime = std::max(_checkTime, checkElapsed.count());
     std::cout << "Legal: " << legal << "\n";
+    endPhaseStats(stats, legal);
     if(!legal)
     {
+        PhaseStats fixStats = startPhaseStats(name + "/legalize");
+        TRACE_SCOPE(Trace::label(name + "/legalize"));
+        ThreadConfig::applySchedule("legalize");
         _legalizer->legalize();
         resetSlack(false);
         _currCost = calCost();
+        endPhaseStats(fixStats, true);
     }
-    saveState("ForceDirected");
-
-    std::cout << "\nStart clustering and banking...\n";
-    size_t prev_ffs_size;
-    std::cout << "Init FFs size: " << _ffs.size() << "\n";
-    do
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    _stateTimes.push_back(elapsed.count());
+    std::cout << name << " time: " << elapsed.count() << "s" << std::endl;
+    // a cut phase does not tell its full time
+    if(!kind.empty() && numFFs > 0 && !timeUp())
     {
-        constructFFsCLKDomain();
-        prev_ffs_size = _ffs.size();
-        for(size_t i = 0; i < _ffs_clkdomains.size(); i++)
+        _phaseRate[kind] = elapsed.count() / numFFs;
+    }
+    saveState(name);
+    if (_verifier != nullptr)
+    {
+        verifyPhase(name);
+    }
+    if (_timingCheckFraction > 0)
+    {
+        checkTiming(name);
+    }
+    return true;
+}
+
+/*
+Recompute the slack of a random sample of the D pins from their paths and report how far the incremental slacks are off.
+Each phase draws a different sample.
+*/
+void Solver::checkTiming(std::string name)
+{
+    TRACE_SCOPE("checkTiming");
+    std::vector<Pin*> pins;
+    std::mt19937 rng(_stateNames.size());
+    std::bernoulli_distribution pick(std::min(1.0, _timingCheckFraction));
+    size_t numPins = 0;
+    for (auto ff : _ffs)
+    {
+        for (auto inPin : ff->getInputPins())
         {
-            std::vector<std::vector<FF*>> cluster;
-            if (_ffs_clkdomains[i].size() > MAX_CLUSTER_SIZE)
+            numPins++;
+            if (pick(rng))
             {
-                cluster = clusteringFFs(i);
-            }
-            else
-            {
-                cluster.push_back(_ffs_clkdomains[i]);
+                pins.push_back(inPin);
             }
-            greedyBanking(cluster);
         }
-        std::cout << "FFs size after greedy banking: " << _ffs.size() << "\n";
-    } while (prev_ffs_size != _ffs.size());
-    _currCost = calCost();
-    std::cout << "==> Cost after clustering and banking: " << _currCost << "\n";
-
-    if(calTime)
+    }
+    const long numSampled = pins.size();
+    std::vector<double> errors(numSampled);
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(ThreadConfig::threads())
+    #endif
+    for (long i = 0; i < numSampled; i++)
     {
-        end = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<double> elapsed = end - start;
-        _stateTimes.push_back(elapsed.count());
-        std::cout << "Clustering and banking time: " << elapsed.count() << "s" << std::endl;
-        start = std::chrono::high_resolution_clock::now();
+        errors[i] = std::abs(pins[i]->getSlack() - pins[i]->recomputeSlack());
     }
 
-    legal = check();
-    std::cout << "Legal: " << legal << "\n";
-    if(!legal)
+    size_t worst = 0;
+    size_t numWrong = 0;
+    double sum = 0;
+    for (size_t i = 0; i < errors.size(); i++)
     {
-        _legalizer->legalize();
-        resetSlack(false);
-        _currCost = calCost();
+        sum += errors[i];
+        numWrong += (errors[i] > TIMING_CHECK_TOLERANCE);
+        if (errors[i] > errors[worst])
+        {
+            worst = i;
+        }
+    }
+    std::cout << "Timing check " << name << ": " << numSampled << " of " << numPins << " D pins, " << numWrong << " off by more than " << TIMING_CHECK_TOLERANCE;
+    if (numSampled > 0)
+    {
+        std::vector<double> sorted = errors;
+        std::sort(sorted.begin(), sorted.end());
+        std::cout << ", |error| mean " << sum / numSampled << " p50 " << sorted[numSampled / 2] << " p99 " << sorted[numSampled * 99 / 100] << " max " << sorted.back();
+        if (numWrong > 0)
+        {
+            std::cout << " at " << pins[worst]->getCell()->getInstName() << "/" << pins[worst]->getName();
+        }
     }
-    saveState("Banking");
+    std::cout << "\n";
+    if (numWrong > 0)
+    {
+        _timingCheckFailures++;
+    }
+}
 
-    std::cout << "\nStart to force directed placement (second)...\n";
-    iterativePlacementLegal();
-    _currCost = calCost();
-    std::cout << "==> Cost after force directed placement (second): " << _currCost << "\n";
-    
-    if(calTime)
+bool Solver::setVerify(std::string inputFile)
+{
+    delete _verifier;
+    _verifier = new Evaluator();
+    if (!_verifier->loadInput(inputFile))
     {
-        end = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<double> elapsed = end - start;
-        _stateTimes.push_back(elapsed.count());
-        std::cout << "Force directed placement (second) time: " << elapsed.count() << "s" << std::endl;
-        start = std::chrono::high_resolution_clock::now();
+        delete _verifier;
+        _verifier = nullptr;
+        return false;
     }
+    return true;
+}
 
-    legal = check();
-    std::cout << "Legal: " << legal << "\n";
-    if(!legal)
+/*
+Write the current placement, evaluate it from scratch and compare with the incremental cost
+*/
+void Solver::verifyPhase(std::string name)
+{
+    TRACE_SCOPE("verify");
+    PlacementSnapshot snapshot;
+    takeSnapshot(snapshot);
+    std::stringstream out;
+    writeSnapshot(snapshot, out);
+    EvalResult result;
+    if (!_verifier->evaluate(out, result))
+    {
+        _verifyFailures++;
+        return;
+    }
+    // the timing of the solver follows the paths found by parse_input, recompute it from them
+    double pathTns = 0;
+    for (auto ff : _ffs)
     {
-        _legalizer->legalize();
-        resetSlack(false);
-        _currCost = calCost();
+        for (auto inPin : ff->getInputPins())
+        {
+            pathTns += std::max(0.0, -inPin->recomputeSlack());
+        }
+    }
+    const CostComponents c = calCostComponents();
+    const double expectedCost = ALPHA * pathTns + BETA * result.power + GAMMA * result.area + LAMBDA * result.bins;
+    auto differ = [](double a, double b) { return std::abs(a - b) > 1e-6 * std::max(1.0, std::abs(b)); };
+    const bool drift = differ(_currCost, expectedCost) || differ(c.tns, pathTns) || differ(c.power, result.power) || differ(c.area, result.area) || c.bins != result.bins;
+    std::cout << "Verify " << name << ": " << (result.ok() && !drift ? "OK" : "FAILED") << "\n";
+    if (drift)
+    {
+        std::cout << "  cost " << _currCost << " (from scratch " << expectedCost << ")\n";
+        std::cout << "  TNS " << c.tns << " (" << pathTns << "), power " << c.power << " (" << result.power << ")";
+        std::cout << ", area " << c.area << " (" << result.area << "), bins " << c.bins << " (" << result.bins << ")\n";
+    }
+    if (!result.ok())
+    {
+        std::cout << "  mapping errors " << result.mappingErrors << ", placement errors " << result.placementErrors << "\n";
+    }
+    if (differ(pathTns, result.tns))
+    {
+        // reconvergent paths are traced once by parse_input, the evaluator takes the longest of all
+        std::cout << "  note: TNS of the traced paths " << pathTns << ", of the full netlist " << result.tns << "\n";
     }
-    saveState("ForceDirected2");
+    if (drift || !result.ok())
+    {
+        _verifyFailures++;
+    }
+}
+
+/*
+Start measuring a phase
+*/
+PhaseStats Solver::startPhaseStats(std::string name)
+{
+    PhaseStats stats;
+    stats.name = name;
+    stats.costEvals = _counters.costEvals;
+    stats.placeableCalls = _counters.placeableCalls;
+    stats.movesAccepted = _counters.movesAccepted;
+    stats.banks = _counters.banks;
+    stats.cpuStart = std::clock();
+    stats.wallStart = std::chrono::steady_clock::now();
+    return stats;
+}
 
-    std::cout << "\nStart clustering and banking...\n";
+/*
+Finish measuring a phase and record it, the cost components are taken after the clocks stop
+*/
+void Solver::endPhaseStats(PhaseStats& stats, bool legal)
+{
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - stats.wallStart;
+    stats.wallTime = wall.count();
+    stats.cpuTime = double(std::clock() - stats.cpuStart) / CLOCKS_PER_SEC;
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    stats.peakRSS = usage.ru_maxrss;
+    stats.costEvals = _counters.costEvals - stats.costEvals;
+    stats.placeableCalls = _counters.placeableCalls - stats.placeableCalls;
+    stats.movesAccepted = _counters.movesAccepted - stats.movesAccepted;
+    stats.banks = _counters.banks - stats.banks;
+    stats.numFFs = _ffs.size();
+    stats.cost = _currCost;
+    stats.components = calCostComponents();
+    stats.legal = legal;
+    _phaseStats.push_back(stats);
+}
+
+void Solver::runForceDirected()
+{
+    iterativePlacementLegal();
+    _currCost = calCost();
+}
+
+void Solver::runBanking()
+{
+    size_t prev_ffs_size;
     std::cout << "Init FFs size: " << _ffs.size() << "\n";
+    resetBankingCache();
     do
     {
         constructFFsCLKDomain();
         prev_ffs_size = _ffs.size();
-        for(size_t i = 0; i < _ffs_clkdomains.size(); i++)
+        for(size_t i = 0; i < _ffs_clkdomains.size() && !timeUp(); i++)
         {
             std::vector<std::vector<FF*>> cluster;
-            if (_ffs_clkdomains[i].size() > MAX_CLUSTER_SIZE)
+            if (_ffs_clkdomains[i].size() > size_t(MAX_CLUSTER_SIZE))
             {
                 cluster = clusteringFFs(i);
             }
@@ -1310,64 +1862,8 @@ void Solver::solve()
             greedyBanking(cluster);
         }
         std::cout << "FFs size after greedy banking: " << _ffs.size() << "\n";
-    } while (prev_ffs_size != _ffs.size());
+    } while (prev_ffs_size != _ffs.size() && !timeUp());
     _currCost = calCost();
-    std::cout << "==> Cost after clustering and banking: " << _currCost << "\n";
-
-    if(calTime)
-    {
-        end = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<double> elapsed = end - start;
-        _stateTimes.push_back(elapsed.count());
-        std::cout << "Clustering and banking time: " << elapsed.count() << "s" << std::endl;
-        start = std::chrono::high_resolution_clock::now();
-    }
-
-    legal = check();
-    std::cout << "Legal: " << legal << "\n";
-    if(!legal)
-    {
-        _legalizer->legalize();
-        resetSlack(false);
-        _currCost = calCost();
-    }
-    saveState("Banking2");
-
-    std::cout << "\nStart to force directed placement (third)...\n";
-    iterativePlacementLegal();
-    _currCost = calCost();
-    std::cout << "==> Cost after force directed placement (third): " << _currCost << "\n";
-    
-    if(calTime)
-    {
-        end = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<double> elapsed = end - start;
-        _stateTimes.push_back(elapsed.count());
-        std::cout << "Force directed placement (third) time: " << elapsed.count() << "s" << std::endl;
-        start = std::chrono::high_resolution_clock::now();
-    }
-
-    if (calTime)
-    {
-        end = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<double> elapsed = end - start_solve_time;
-        _stateTimes.push_back(elapsed.count());
-        std::cout << "Total solve time: " << elapsed.count() << "s" << std::endl;
-    }
-
-    legal = check();
-    std::cout << "Legal: " << legal << "\n";
-    if(!legal)
-    {
-        _legalizer->legalize();
-        resetSlack(false);
-        _currCost = calCost();
-    }
-    saveState("ForceDirected3");
-
-    std::cout << "\nCost after solving: " << _currCost << "\n";
-    std::cout << "Cost difference: " << _currCost - _initCost << "\n";
-    std::cout << "Cost difference percentage: " << (_currCost - _initCost) / _initCost * 100 << "%\n";
 }
 
 /*
@@ -1510,7 +2006,7 @@ std::vector<std::vector<FF*>> Solver::clusteringFFs(size_t clkdomain_idx)
     std::vector<FF*> FFs = _ffs_clkdomains[clkdomain_idx];
     std::vector<std::vector<FF*>> clusters;
     std::vector<bool> visited(FFs.size(), false);
-    int REGION_QUERY_EPS = (DIE_UP_RIGHT_X - DIE_LOW_LEFT_X) / 50;
+    int REGION_QUERY_EPS = (DIE_UP_RIGHT_X - DIE_LOW_LEFT_X) / BANKING_REGION_DIVISOR;
     if (REGION_QUERY_EPS < 1)
     {
         REGION_QUERY_EPS = DIE_UP_RIGHT_X - DIE_LOW_LEFT_X;
@@ -1539,7 +2035,7 @@ std::vector<std::vector<FF*>> Solver::clusteringFFs(size_t clkdomain_idx)
             
             visited[idx] = true;
             cluster.push_back(FFs[idx]);
-            if(cluster.size() >= MAX_CLUSTER_SIZE)
+            if(cluster.size() >= size_t(MAX_CLUSTER_SIZE))
                 break;
         }
         clusters.push_back(cluster);
@@ -1548,69 +2044,286 @@ std::vector<std::vector<FF*>> Solver::clusteringFFs(size_t clkdomain_idx)
     return clusters;
 }
 
-double Solver::cal_banking_gain(FF* ff1, FF* ff2, LibCell* targetFF, int& result_x, int& result_y)
+/*
+Weighted median of the points, the cost sum(w_i * |x - x_i|) is minimized for any x in [lo, hi]
+*/
+static void weightedMedian(std::vector<std::pair<int, double>>& points, int& lo, int& hi)
+{
+    std::sort(points.begin(), points.end());
+    double total = 0;
+    for (auto p : points)
+    {
+        total += p.second;
+    }
+    double cum = 0;
+    size_t i = 0;
+    while (i + 1 < points.size() && cum + points[i].second < total / 2)
+    {
+        cum += points[i++].second;
+    }
+    lo = points[i].first;
+    hi = (cum + points[i].second == total / 2 && i + 1 < points.size()) ? points[i+1].first : lo;
+}
+
+/*
+Candidate sites to place targetFF banked from ff1 and ff2
+The slack cost is piecewise-linear in the Manhattan distance between the pins of the banked FF and
+the pins connected to them, so the optimal region of the lower left corner is the weighted median
+of the connected pins shifted by the pin offsets, where the pins on negative slack are dominant
+Return the sites near the optimal region, followed by the sites of ff1 and ff2 and the middle of them
+*/
+std::vector<Site*> Solver::bankingCandidateSites(FF* ff1, FF* ff2, LibCell* targetFF)
 {
-    double remove_gain = 0;
-    remove_gain -= _binMap->removeCell(ff1,true);
-    remove_gain -= _binMap->removeCell(ff2,true);
-    
-    const std::string ff1_name = ff1->getInstName();
-    const std::string ff2_name = ff2->getInstName();
-    ff1->setInstName(DUMB_CELL_NAME);
-    ff2->setInstName(DUMB_CELL_NAME);
-
-    int leftDownX = std::min(ff1->getX(), ff2->getX());
-    int leftDownY = std::min(ff1->getY(), ff2->getY());
-    int rightUpX = std::max(ff1->getX() + ff1->getWidth(), ff2->getX() + ff2->getWidth());
-    int rightUpY = std::max(ff1->getY() + ff1->getHeight(), ff2->getY() + ff2->getHeight());
-    double max_gain = -INFINITY;
-
-    // set candidates
-    std::vector<std::pair<int, int>> candidates;
     // HYPER
-    const int div = 4;
-    const double x_stride = double(rightUpX - leftDownX) / div;
-    const double y_stride = double(rightUpY - leftDownY) / div;
-    for(int i = 0; i < div; i++)
+    const double critWeight = ALPHA * DISP_DELAY;
+    const double nonCritWeight = critWeight * BANKING_NONCRITICAL_WEIGHT;
+    std::vector<std::pair<int, double>> xs, ys;
+    const int ff1_bit = ff1->getBit();
+    const int ff2_bit = ff2->getBit();
+    for (int i = 0; i < ff1_bit+ff2_bit; i++)
     {
-        for(int j = 0; j < div; j++)
+        FF* workingFF = (i < ff1_bit) ? ff1 : ff2;
+        const int op_idx = (i < ff1_bit) ? i : i - ff1_bit;
+        // D pin to its fanin
+        Pin* inPin = workingFF->getInputPins()[op_idx];
+        Pin* faninPin = inPin->getFaninPin();
+        if (faninPin != nullptr && (faninPin->getType() == PinType::INPUT || (faninPin->getCell() != ff1 && faninPin->getCell() != ff2)))
+        {
+            const double w = (inPin->getSlack() < 0) ? critWeight : nonCritWeight;
+            xs.push_back(std::make_pair(faninPin->getGlobalX() - targetFF->inputPins[i]->getX(), w));
+            ys.push_back(std::make_pair(faninPin->getGlobalY() - targetFF->inputPins[i]->getY(), w));
+        }
+        // Q pin to the first pin of each path to the next stage
+        Pin* outPin = workingFF->getOutputPins()[op_idx];
+        const std::vector<std::vector<Pin*>>& paths = outPin->getPathToNextStagePins();
+        for (size_t k = 0; k < paths.size(); k++)
         {
-            double x = leftDownX + i * x_stride;
-            double y = leftDownY + j * y_stride;
-            candidates.push_back(std::make_pair(int(x), int(y)));
+            const std::vector<Pin*>& path = paths[k];
+            Pin* nextStagePin = path.front();
+            if (nextStagePin->getType() != PinType::FF_D || path.size() < 2)
+                continue;
+            if (nextStagePin->getCell() == ff1 || nextStagePin->getCell() == ff2)
+                continue;
+            Pin* firstPin = path[path.size()-2];
+            const double w = (nextStagePin->getSlack() < 0) ? critWeight : nonCritWeight;
+            xs.push_back(std::make_pair(firstPin->getGlobalX() - targetFF->outputPins[i]->getX(), w));
+            ys.push_back(std::make_pair(firstPin->getGlobalY() - targetFF->outputPins[i]->getY(), w));
         }
     }
 
-    #pragma omp parallel for num_threads(NUM_THREADS)
-        for(size_t i=0;i<candidates.size();i++)
+    int xLo, xHi, yLo, yHi;
+    if (xs.empty())
+    {
+        xLo = xHi = (std::min(ff1->getX(), ff2->getX()) + std::max(ff1->getX(), ff2->getX())) / 2;
+        yLo = yHi = (std::min(ff1->getY(), ff2->getY()) + std::max(ff1->getY(), ff2->getY())) / 2;
+    }
+    else
+    {
+        weightedMedian(xs, xLo, xHi);
+        weightedMedian(ys, yLo, yHi);
+    }
+    auto clampX = [targetFF](int x) { return std::max(DIE_LOW_LEFT_X, std::min(x, DIE_UP_RIGHT_X - targetFF->width)); };
+    auto clampY = [targetFF](int y) { return std::max(DIE_LOW_LEFT_Y, std::min(y, DIE_UP_RIGHT_Y - targetFF->height)); };
+
+    std::vector<Site*> sites;
+    auto addSite = [this, &sites](int x, int y) {
+        Site* site = _siteMap->getNearestSite(x, y);
+        if (site != nullptr && std::find(sites.begin(), sites.end(), site) == sites.end())
         {
-            Site* targetSite = _siteMap->getNearestSite(candidates[i].first, candidates[i].second);
-            if (targetSite == nullptr)
-                continue;
-            const int target_x = targetSite->getX();
-            const int target_y = targetSite->getY();
+            sites.push_back(site);
+        }
+    };
+    const int centerX = clampX((xLo + xHi) / 2);
+    const int centerY = clampY((yLo + yHi) / 2);
+    addSite(centerX, centerY);
+    if (!sites.empty())
+    {
+        // the neighbors of the center site
+        const int stepX = sites[0]->getWidth();
+        const int stepY = sites[0]->getHeight();
+        addSite(clampX(sites[0]->getX() - stepX), sites[0]->getY());
+        addSite(clampX(sites[0]->getX() + stepX), sites[0]->getY());
+        addSite(sites[0]->getX(), clampY(sites[0]->getY() - stepY));
+        addSite(sites[0]->getX(), clampY(sites[0]->getY() + stepY));
+    }
+    // the corners of the optimal region
+    addSite(clampX(xLo), clampY(yLo));
+    addSite(clampX(xHi), clampY(yHi));
+    // fallback: the sites released by the pair and the middle of them
+    addSite(clampX(ff1->getX()), clampY(ff1->getY()));
+    addSite(clampX(ff2->getX()), clampY(ff2->getY()));
+    addSite(clampX((ff1->getX() + ff2->getX()) / 2), clampY((ff1->getY() + ff2->getY()) / 2));
+    return sites;
+}
 
-            if(!placeable(targetFF, target_x, target_y))
-                continue;
-            
-            double gain = -calCostBankFF(ff1, ff2, targetFF, target_x, target_y, false);
-            gain -= _binMap->trialLibCell(targetFF, target_x, target_y);
+/*
+Evaluate banking ff1 and ff2 into every target FF with the bit width of the pair
+The shared state of the pair (bin removal) is computed once, and the candidate sites,
+placeability and bin cost once per footprint (width, height) of the target FFs
+Results are memoized per (pair, footprint) until one of the FFs is touched by a banking
+Return the best target, targetFF is nullptr if no target is placeable
+*/
+PairInfo Solver::evalBankingPair(FF* ff1, FF* ff2, const std::vector<LibCell*>& targetFFs)
+{
+    PairInfo best{ff1, ff2, nullptr, 0, 0, -INFINITY};
+    const int bit = ff1->getBit() + ff2->getBit();
+    const NameId ff1_name = ff1->getInstNameId();
+    const NameId ff2_name = ff2->getInstNameId();
+    const size_t ff1_stamp = _bankingDirtyStamp[ff1_name];
+    const size_t ff2_stamp = _bankingDirtyStamp[ff2_name];
+    auto consider = [&best](LibCell* targetFF, int x, int y, double gain) {
+        if (targetFF != nullptr && gain > best.gain)
+        {
+            best.targetFF = targetFF;
+            best.targetX = x;
+            best.targetY = y;
+            best.gain = gain;
+        }
+    };
+
+    // group the target FFs by footprint, reusing the memoized footprints
+    std::vector<BankingCacheKey> footprintKeys;
+    std::vector<std::vector<LibCell*>> footprints;
+    for (auto targetFF : targetFFs)
+    {
+        if (targetFF->bit != bit)
+            continue;
+        const BankingCacheKey key{ff1_name, ff2_name, targetFF->width, targetFF->height};
+        auto cached = _bankingGainCache.find(key);
+        if (cached != _bankingGainCache.end() && cached->second.stamp >= ff1_stamp && cached->second.stamp >= ff2_stamp)
+        {
+            const BankingCacheEntry& entry = cached->second;
+            consider(entry.targetFF, entry.targetX, entry.targetY, entry.gain);
+            continue;
+        }
+        size_t idx = std::find(footprintKeys.begin(), footprintKeys.end(), key) - footprintKeys.begin();
+        if (idx == footprintKeys.size())
+        {
+            footprintKeys.push_back(key);
+            footprints.push_back(std::vector<LibCell*>());
+        }
+        footprints[idx].push_back(targetFF);
+    }
+    if (footprints.empty())
+    {
+        return best;
+    }
 
-            #pragma omp critical
+    // shared state of the pair
+    double remove_gain = 0;
+    remove_gain -= _binMap->removeCell(ff1,true);
+    remove_gain -= _binMap->removeCell(ff2,true);
+    ff1->setInstName(DUMB_CELL_ID);
+    ff2->setInstName(DUMB_CELL_ID);
+
+    for (size_t f = 0; f < footprints.size(); f++)
+    {
+        const std::vector<LibCell*>& libs = footprints[f];
+        LibCell* footprintFF = libs[0];
+        // candidate sites near the optimal region of each target FF
+        std::vector<Site*> candidates;
+        for (auto targetFF : libs)
+        {
+            for (auto site : bankingCandidateSites(ff1, ff2, targetFF))
             {
-                if(gain > max_gain)
+                if (std::find(candidates.begin(), candidates.end(), site) == candidates.end())
                 {
-                    max_gain = gain;
-                    result_x = target_x;
-                    result_y = target_y;
+                    candidates.push_back(site);
                 }
             }
         }
+        BankingCacheEntry result{nullptr, 0, 0, -INFINITY, _bankingStamp};
+        size_t result_idx = candidates.size();
+        #pragma omp parallel for schedule(runtime) num_threads(ThreadConfig::threads())
+            for(size_t i = 0; i < candidates.size(); i++)
+            {
+                TRACE_SCOPE("bankingCandidate");
+                const int target_x = candidates[i]->getX();
+                const int target_y = candidates[i]->getY();
+                if(!placeable(footprintFF, target_x, target_y))
+                    continue;
+                const double add_cost = _binMap->trialLibCell(footprintFF, target_x, target_y);
+                for (auto targetFF : libs)
+                {
+                    const double gain = -calCostBankFF(ff1, ff2, targetFF, target_x, target_y, false) - add_cost + remove_gain;
+                    // the scope covers the wait for the critical section
+                    TRACE_SCOPE("bankingCandidate/critical");
+                    HOTPATH_CRITICAL_WAIT_BEGIN(waitStart);
+                    #pragma omp critical
+                    {
+                        HOTPATH_CRITICAL_ENTERED(waitStart, BANKING);
+                        if (gain > result.gain || (gain == result.gain && i < result_idx))
+                        {
+                            result.targetFF = targetFF;
+                            result.targetX = target_x;
+                            result.targetY = target_y;
+                            result.gain = gain;
+                            result_idx = i;
+                        }
+                    }
+                }
+            }
+        _bankingGainCache[footprintKeys[f]] = result;
+        consider(result.targetFF, result.targetX, result.targetY, result.gain);
+    }
 
     ff1->setInstName(ff1_name);
     ff2->setInstName(ff2_name);
-    
-    return max_gain + remove_gain;
+    return best;
+}
+
+/*
+Invalidate the memoized banking gains affected by the banked FF
+The FFs sharing timing paths with the banked FF and the FFs of the cluster near it are touched
+*/
+void Solver::touchBankingCache(FF* bankedFF, const std::vector<FF*>& cluster)
+{
+    const size_t stamp = ++_bankingStamp;
+    _bankingDirtyStamp[bankedFF->getInstNameId()] = stamp;
+    // HYPER
+    const int radius = BANKING_DIRTY_FACTOR * (bankedFF->getWidth() + bankedFF->getHeight());
+    for (auto ff : cluster)
+    {
+        if (abs(ff->getX() - bankedFF->getX()) + abs(ff->getY() - bankedFF->getY()) <= radius)
+        {
+            _bankingDirtyStamp[ff->getInstNameId()] = stamp;
+        }
+    }
+    auto touchCell = [this, stamp](Cell* cell) {
+        if (cell != nullptr && cell->getCellType() == CellType::FF)
+        {
+            _bankingDirtyStamp[cell->getInstNameId()] = stamp;
+        }
+    };
+    for (auto inPin : bankedFF->getInputPins())
+    {
+        for (auto prevPin : inPin->getPrevStagePins())
+        {
+            touchCell(prevPin->getCell());
+        }
+    }
+    for (auto outPin : bankedFF->getOutputPins())
+    {
+        for (auto nextPin : outPin->getNextStagePins())
+        {
+            touchCell(nextPin->getCell());
+            // FFs sharing the next stage pin
+            for (auto prevPin : nextPin->getPrevStagePins())
+            {
+                touchCell(prevPin->getCell());
+            }
+        }
+    }
+}
+
+/*
+Drop all memoized banking gains, call when FFs are moved outside banking
+*/
+void Solver::resetBankingCache()
+{
+    _bankingGainCache.clear();
+    _bankingDirtyStamp.clear();
+    _bankingStamp = 0;
 }
 
 void Solver::greedyBanking(std::vector<std::vector<FF*>> clusters)
@@ -1626,15 +2339,17 @@ void Solver::greedyBanking(std::vector<std::vector<FF*>> clusters)
 
     for(auto cluster : clusters)
     {
+        if(timeUp())
+            break;
         if(cluster.size() < 2)
             continue;
-        // prune pairs
-        std::vector<std::pair<FF*, FF*>> pairs;
-        std::vector<std::pair<int, double>> pair_scores;
-        int pair_count = 0;
-        #pragma omp parallel for num_threads(NUM_THREADS)
+        // prune pairs, the pairs of each i are kept apart and merged in the order of i
+        // so the order of the pairs does not depend on the thread timing
+        std::vector<std::vector<std::pair<size_t, double>>> rowPairs(cluster.size());
+        #pragma omp parallel for schedule(runtime) num_threads(ThreadConfig::threads())
             for (size_t i = 0; i < cluster.size(); i++)
             {
+                TRACE_SCOPE("prunePairs");
                 for (size_t j = i + 1; j < cluster.size(); j++)
                 {
                     const int bit = cluster[i]->getBit() + cluster[j]->getBit();
@@ -1650,20 +2365,27 @@ void Solver::greedyBanking(std::vector<std::vector<FF*>> clusters)
                     double dist = std::abs(cluster[i]->getX() - cluster[j]->getX()) + std::abs(cluster[i]->getY() - cluster[j]->getY());
                     int pin_count = cluster[i]->getNSPinCount() + cluster[j]->getNSPinCount();
                     // HYPER
-                    score -= dist * DISP_DELAY * ALPHA * pin_count / 2;
+                    score -= dist * DISP_DELAY * ALPHA * pin_count / BANKING_PRUNE_DIVISOR;
                     if (score < 0)
                     {
                         continue;
                     }
-                    #pragma omp critical
-                    {
-                        pairs.push_back(std::make_pair(cluster[i], cluster[j]));
-                        pair_scores.push_back(std::make_pair(pair_count++, score));
-                    }
+                    rowPairs[i].push_back(std::make_pair(j, score));
                 }
             }
-        // sort pairs
-        std::sort(pair_scores.begin(), pair_scores.end(), [](const std::pair<int, double>& a, const std::pair<int, double>& b) {
+        std::vector<std::pair<FF*, FF*>> pairs;
+        std::vector<std::pair<int, double>> pair_scores;
+        int pair_count = 0;
+        for (size_t i = 0; i < cluster.size(); i++)
+        {
+            for (const auto& p : rowPairs[i])
+            {
+                pairs.push_back(std::make_pair(cluster[i], cluster[p.first]));
+                pair_scores.push_back(std::make_pair(pair_count++, p.second));
+            }
+        }
+        // sort pairs, equal scores keep the merged order
+        std::stable_sort(pair_scores.begin(), pair_scores.end(), [](const std::pair<int, double>& a, const std::pair<int, double>& b) {
             return a.second > b.second;
         });
 
@@ -1671,107 +2393,294 @@ void Solver::greedyBanking(std::vector<std::vector<FF*>> clusters)
         for (auto ps : pair_scores)
         {
             const std::pair<FF*, FF*>& p = pairs[ps.first];
-            FF* ff1 = p.first;
-            FF* ff2 = p.second;
-            double pair_max_gain = 0.0;
-            int pair_result_x = 0;
-            int pair_result_y = 0;
-            LibCell* pair_targetFF = nullptr;
-            for(auto ff : targetFFs)
+            PairInfo pi = evalBankingPair(p.first, p.second, targetFFs);
+            if (pi.targetFF != nullptr && pi.gain > 0)
             {
-                if(ff->bit == ff1->getBit() + ff2->getBit())
+                pair_infos.push_back(pi);
+            }
+        }
+        // commit a conflict-free set of pairs in one step
+        std::vector<size_t> selected = matchBankingPairs(pair_infos);
+        for (size_t idx : selected)
+        {
+            PairInfo& pi = pair_infos[idx];
+            const NameId ff1_name = pi.ff1->getInstNameId();
+            const NameId ff2_name = pi.ff2->getInstNameId();
+            pi.ff1->setInstName(DUMB_CELL_ID);
+            pi.ff2->setInstName(DUMB_CELL_ID);
+            bool isPlaceable = placeable(pi.targetFF, pi.targetX, pi.targetY);
+            pi.ff1->setInstName(ff1_name);
+            pi.ff2->setInstName(ff2_name);
+            if (isPlaceable)
+            {
+                FF* bankedFF = bankFFs(pi.ff1, pi.ff2, pi.targetFF, pi.targetX, pi.targetY);
+                if (bankedFF != nullptr)
                 {
-                    int x, y;
-                    double gain = cal_banking_gain(ff1, ff2, ff, x, y);
-                    if (gain > pair_max_gain)
-                    {
-                        pair_max_gain = gain;
-                        pair_result_x = x;
-                        pair_result_y = y;
-                        pair_targetFF = ff;
-                    }
+                    // keep the cluster alive for the cache invalidation
+                    std::replace(cluster.begin(), cluster.end(), pi.ff1, bankedFF);
+                    cluster.erase(std::remove(cluster.begin(), cluster.end(), pi.ff2), cluster.end());
+                    touchBankingCache(bankedFF, cluster);
                 }
             }
-            if (pair_max_gain > 0)
+        }
+    }
+}
+
+/*
+Select a conflict-free set of pairs (a matching over the FFs) with maximum total gain
+Start from the greedy matching by gain, then apply local augmentations until no improvement:
+an unmatched pair (u,v) replaces the pairs of u and v, and the freed partners are rematched
+to their best free neighbors
+Return the indices of the selected pairs, sorted by gain in descending order
+*/
+std::vector<size_t> Solver::matchBankingPairs(const std::vector<PairInfo>& pairInfos)
+{
+    const size_t numPairs = pairInfos.size();
+    std::vector<size_t> selected;
+    if (numPairs == 0)
+    {
+        return selected;
+    }
+    // index the FFs and build the adjacency lists
+    std::unordered_map<FF*, int> ffIndex;
+    std::vector<std::pair<int, int>> ends(numPairs);
+    for (size_t e = 0; e < numPairs; e++)
+    {
+        FF* ffs[2] = {pairInfos[e].ff1, pairInfos[e].ff2};
+        int idx[2];
+        for (int k = 0; k < 2; k++)
+        {
+            auto it = ffIndex.find(ffs[k]);
+            if (it == ffIndex.end())
             {
-                pair_infos.push_back(PairInfo{ff1, ff2, pair_targetFF, pair_result_x, pair_result_y, pair_max_gain});
+                it = ffIndex.emplace(ffs[k], int(ffIndex.size())).first;
             }
+            idx[k] = it->second;
         }
-        std::sort(pair_infos.begin(), pair_infos.end(), [](const PairInfo& a, const PairInfo& b) {
-            return a.gain > b.gain;
-        });
-        std::unordered_map<PairInfo*, bool> locked;
-        for (auto pi : pair_infos)
+        ends[e] = std::make_pair(idx[0], idx[1]);
+    }
+    const int numFFs = ffIndex.size();
+    std::vector<std::vector<size_t>> adj(numFFs);
+    for (size_t e = 0; e < numPairs; e++)
+    {
+        adj[ends[e].first].push_back(e);
+        adj[ends[e].second].push_back(e);
+    }
+    std::vector<size_t> order(numPairs);
+    for (size_t e = 0; e < numPairs; e++)
+    {
+        order[e] = e;
+    }
+    std::stable_sort(order.begin(), order.end(), [&pairInfos](size_t a, size_t b) {
+        return pairInfos[a].gain > pairInfos[b].gain;
+    });
+
+    // matched pair of each FF, -1 if unmatched
+    const long UNMATCHED = -1;
+    std::vector<long> mate(numFFs, UNMATCHED);
+    auto other = [&ends](size_t e, int v) { return (ends[e].first == v) ? ends[e].second : ends[e].first; };
+    auto match = [&](size_t e) { mate[ends[e].first] = e; mate[ends[e].second] = e; };
+    auto unmatch = [&](size_t e) { mate[ends[e].first] = UNMATCHED; mate[ends[e].second] = UNMATCHED; };
+    // best pair joining v to a free FF, -1 if none
+    auto bestFreePair = [&](int v) -> long {
+        long best = UNMATCHED;
+        for (size_t e : adj[v])
         {
-            locked[&pi] = false;
+            const int w = other(e, v);
+            if (mate[w] != UNMATCHED)
+                continue;
+            if (best == UNMATCHED || pairInfos[e].gain > pairInfos[best].gain)
+                best = e;
         }
-        if (!pair_infos.empty() && pair_infos[0].gain > 0)
+        return best;
+    };
+
+    // 1. greedy matching
+    for (size_t e : order)
+    {
+        if (mate[ends[e].first] == UNMATCHED && mate[ends[e].second] == UNMATCHED)
+        {
+            match(e);
+        }
+    }
+    // 2. local augmentations
+    // HYPER
+    const double eps = 1e-9;
+    bool improved = true;
+    for (int round = 0; improved && round < BANKING_MATCH_ROUNDS; round++)
+    {
+        improved = false;
+        for (size_t e : order)
         {
-            for (size_t i = 0; i < pair_infos.size(); i++)
+            const int u = ends[e].first;
+            const int v = ends[e].second;
+            if (mate[u] == long(e))
+                continue;
+            const long mu = mate[u];
+            const long mv = mate[v];
+            double delta = pairInfos[e].gain;
+            delta -= (mu != UNMATCHED) ? pairInfos[mu].gain : 0;
+            delta -= (mv != UNMATCHED) ? pairInfos[mv].gain : 0;
+            // tentatively apply and rematch the freed partners
+            const int a = (mu != UNMATCHED) ? other(mu, u) : -1;
+            const int b = (mv != UNMATCHED) ? other(mv, v) : -1;
+            if (mu != UNMATCHED) unmatch(mu);
+            if (mv != UNMATCHED) unmatch(mv);
+            match(e);
+            long ra = (a != -1) ? bestFreePair(a) : UNMATCHED;
+            if (ra != UNMATCHED) match(ra);
+            // b may already be taken by the rematch of a
+            long rb = (b != -1 && mate[b] == UNMATCHED) ? bestFreePair(b) : UNMATCHED;
+            if (rb != UNMATCHED) match(rb);
+            double newDelta = delta;
+            newDelta += (ra != UNMATCHED) ? pairInfos[ra].gain : 0;
+            newDelta += (rb != UNMATCHED) ? pairInfos[rb].gain : 0;
+            if (newDelta > eps)
             {
-                PairInfo& pi = pair_infos[i];
-                if (locked[&pi])
-                {
-                    continue;
-                }
-                const std::string ff1_name = pi.ff1->getInstName();
-                const std::string ff2_name = pi.ff2->getInstName();
-                pi.ff1->setInstName(DUMB_CELL_NAME);
-                pi.ff2->setInstName(DUMB_CELL_NAME);
-                bool isPlaceable = placeable(pi.targetFF, pi.targetX, pi.targetY);
-                pi.ff1->setInstName(ff1_name);
-                pi.ff2->setInstName(ff2_name);
-                if (isPlaceable)
-                {
-                    for (size_t j = i + 1; j < pair_infos.size(); j++)
-                    {
-                        PairInfo& pi2 = pair_infos[j];
-                        if (pi2.ff1 == pi.ff1 || pi2.ff1 == pi.ff2 || pi2.ff2 == pi.ff1 || pi2.ff2 == pi.ff2)
-                        {
-                            locked[&pi2] = true;
-                        }
-                    }
-                    bankFFs(pi.ff1, pi.ff2, pi.targetFF, pi.targetX, pi.targetY);
-                }
+                improved = true;
+                continue;
             }
+            // revert
+            if (rb != UNMATCHED) unmatch(rb);
+            if (ra != UNMATCHED) unmatch(ra);
+            unmatch(e);
+            if (mu != UNMATCHED) match(mu);
+            if (mv != UNMATCHED) match(mv);
         }
     }
-}
 
-void Solver::dump(std::vector<std::string>& vecStr) const
-{
-    using namespace std;
-    string s;
-    s = "CellInst " + std::to_string(_ffs.size()) + "\n"; vecStr.push_back(s);
-    for (auto ff : _ffs)
+    for (size_t e : order)
     {
-        s = "Inst " + ff->getInstName() + " " + ff->getCellName() + " " + std::to_string(ff->getX()) + " " + std::to_string(ff->getY()) + "\n";
-        vecStr.push_back(s);
+        if (mate[ends[e].first] == long(e))
+        {
+            selected.push_back(e);
+        }
     }
+    return selected;
+}
+
+/*
+Copy the current FF placement and pin mapping into snapshot
+*/
+void Solver::takeSnapshot(PlacementSnapshot& snapshot)
+{
+    snapshot.ffs.clear();
+    snapshot.pins.clear();
+    snapshot.clkNames.clear();
+    snapshot.ffs.reserve(_ffs.size());
     for (auto ff : _ffs)
     {
+        FFSnapshot record;
+        record.instName = ff->getInstNameId();
+        record.lib = ff->getLibCell();
+        record.x = ff->getX();
+        record.y = ff->getY();
+        record.pinBegin = snapshot.pins.size();
+        record.clkBegin = snapshot.clkNames.size();
         for (auto pin : ff->getInputPins())
         {
-            s = pin->getOriginalName() + " map " + pin->getCell()->getInstName() + "/" + pin->getName() + "\n";
-            vecStr.push_back(s);
+            snapshot.pins.push_back(pin);
         }
         for (auto pin : ff->getOutputPins())
         {
-            s = pin->getOriginalName() + " map " + pin->getCell()->getInstName() + "/" + pin->getName() + "\n";
-            vecStr.push_back(s);
+            snapshot.pins.push_back(pin);
         }
-        Pin* clkPin = ff->getClkPin();
-        std::vector<std::string> clkPinNames = ff->getClkPin()->getOriginalNames();
-        for(auto clkPinName : clkPinNames)
+        for (auto clkPinName : ff->getClkPin()->getOriginalNames())
         {
-            s = clkPinName + " map " + clkPin->getCell()->getInstName() + "/" + clkPin->getName() + "\n";
-            vecStr.push_back(s);
+            snapshot.clkNames.push_back(clkPinName);
         }
+        snapshot.ffs.push_back(record);
+    }
+}
+
+/*
+Format the Inst lines and the pin mapping lines of the FFs [begin, end) of snapshot,
+pin names are taken from the lib cell since the pins may have been moved to other FFs since
+*/
+void Solver::formatSnapshot(const PlacementSnapshot& snapshot, size_t begin, size_t end, OutputBuffer& instBuf, OutputBuffer& mapBuf) const
+{
+    for (size_t i = begin; i < end; i++)
+    {
+        const FFSnapshot& record = snapshot.ffs[i];
+        const LibCell* lib = record.lib;
+        const std::string& instName = NameTable::name(record.instName);
+        instBuf.append("Inst ", 5);
+        instBuf.append(instName);
+        instBuf.append(' ');
+        instBuf.append(lib->cell_name);
+        instBuf.append(' ');
+        instBuf.appendInt(record.x);
+        instBuf.append(' ');
+        instBuf.appendInt(record.y);
+        instBuf.append('\n');
+
+        size_t pinIdx = record.pinBegin;
+        for (int k = 0; k < 2; k++)
+        {
+            const std::vector<Pin*>& libPins = (k == 0) ? lib->inputPins : lib->outputPins;
+            for (auto libPin : libPins)
+            {
+                mapBuf.append(snapshot.pins[pinIdx++]->getOriginalName());
+                mapBuf.append(" map ", 5);
+                mapBuf.append(instName);
+                mapBuf.append('/');
+                mapBuf.append(libPin->getName());
+                mapBuf.append('\n');
+            }
+        }
+        size_t clkEnd = (i + 1 < snapshot.ffs.size()) ? snapshot.ffs[i + 1].clkBegin : snapshot.clkNames.size();
+        for (size_t c = record.clkBegin; c < clkEnd; c++)
+        {
+            mapBuf.append(NameTable::name(snapshot.clkNames[c]));
+            mapBuf.append(" map ", 5);
+            mapBuf.append(instName);
+            mapBuf.append('/');
+            mapBuf.append(lib->clkPin->getName());
+            mapBuf.append('\n');
+        }
+    }
+}
+
+/*
+Write snapshot in the output format.
+The FFs are formatted in chunks into separate buffers in parallel, then the buffers are written in order.
+*/
+void Solver::writeSnapshot(const PlacementSnapshot& snapshot, std::ostream& out) const
+{
+    const size_t chunkSize = 4096;
+    const size_t numFFs = snapshot.ffs.size();
+    const long numChunks = (numFFs + chunkSize - 1) / chunkSize;
+    std::vector<OutputBuffer> instBufs(numChunks);
+    std::vector<OutputBuffer> mapBufs(numChunks);
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic) num_threads(ThreadConfig::threads())
+    #endif
+    for (long c = 0; c < numChunks; c++)
+    {
+        TRACE_SCOPE("formatSnapshot");
+        size_t begin = c * chunkSize;
+        size_t end = std::min(numFFs, begin + chunkSize);
+        formatSnapshot(snapshot, begin, end, instBufs[c], mapBufs[c]);
+    }
+
+    OutputBuffer header;
+    header.append("CellInst ", 9);
+    header.appendInt(numFFs);
+    header.append('\n');
+    header.writeTo(out);
+    for (auto& buf : instBufs)
+    {
+        buf.writeTo(out);
+    }
+    for (auto& buf : mapBufs)
+    {
+        buf.writeTo(out);
     }
 }
 
 void Solver::saveState(std::string stateName, bool legal)
 {
+    TRACE_SCOPE("saveState");
     _stateNames.push_back(stateName);
     _stateCosts.push_back(_currCost);
     _stateLegal.push_back(legal);
@@ -1783,9 +2692,21 @@ void Solver::saveState(std::string stateName, bool legal)
             _bestStateIdx = _stateCosts.size() - 1;
         }
     }
-    std::vector<std::string> vecStr;
-    dump(vecStr);
-    _stateDumps.push_back(vecStr);
+    // keep a snapshot only when there is a new best, or no legal state yet to fall back to
+    if (_bestCost != -1 && _bestStateIdx != _stateCosts.size() - 1)
+    {
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    takeSnapshot(_bestSnapshot);
+    if (!_checkpointFile.empty() && _bestCost != -1)
+    {
+        // write aside and rename so the file is always complete
+        dump_best(_checkpointFile + ".tmp");
+        std::rename((_checkpointFile + ".tmp").c_str(), _checkpointFile.c_str());
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    _dumpTime = std::max(_dumpTime, elapsed.count());
 }
 
 void Solver::report()
@@ -1819,13 +2740,116 @@ void Solver::report()
     std::cout << "------------------------------------------------------------------" << std::endl;
 }
 
-void Solver::dump_best(std::string filename) const
+/*
+Write a number of the report, JSON has no inf or nan
+*/
+static void writeJsonNumber(std::ostream& out, double value)
 {
-    using namespace std;
-    ofstream out(filename);
-    const vector<string>& vecStr = _stateDumps.at((_bestCost != -1) ? _bestStateIdx : _stateDumps.size() - 1);
-    for (auto str : vecStr)
+    if (std::isfinite(value))
+    {
+        out << value;
+    }
+    else
+    {
+        out << "null";
+    }
+}
+
+static void writeJsonString(std::ostream& out, const std::string& value)
+{
+    out << '"';
+    for (char c : value)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out << '\\' << c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c) << std::dec << std::setfill(' ');
+        }
+        else
+        {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+/*
+Write the per-phase statistics of the run as JSON
+*/
+void Solver::writeReport(std::string filename) const
+{
+    std::ofstream out(filename);
+    if (!out)
     {
-        out << str;
+        std::cerr << "Error: cannot open report file " << filename << std::endl;
+        return;
+    }
+    out << std::setprecision(17);
+    out << "{\n";
+    out << "  \"ffs\": " << _ffs.size() << ",\n";
+    out << "  \"threads\": " << ThreadConfig::threads() << ",\n";
+    out << "  \"initial_cost\": ";
+    writeJsonNumber(out, _stateCosts.empty() ? NAN : _stateCosts[0]);
+    out << ",\n  \"best_cost\": ";
+    writeJsonNumber(out, _bestCost);
+    out << ",\n  \"best_phase\": ";
+    if (_bestCost != -1)
+    {
+        writeJsonString(out, _stateNames[_bestStateIdx]);
     }
-}
\ No newline at end of file
+    else
+    {
+        out << "null";
+    }
+    out << ",\n  \"total_time\": ";
+    writeJsonNumber(out, _stateTimes.empty() ? NAN : _stateTimes.back());
+    out << ",\n  \"time_budget\": ";
+    writeJsonNumber(out, _timeBudget);
+    out << ",\n  \"phases\": [";
+    for (size_t i = 0; i < _phaseStats.size(); i++)
+    {
+        const PhaseStats& stats = _phaseStats[i];
+        out << (i ? ",\n" : "\n") << "    {\"name\": ";
+        writeJsonString(out, stats.name);
+        out << ", \"wall_time\": ";
+        writeJsonNumber(out, stats.wallTime);
+        out << ", \"cpu_time\": ";
+        writeJsonNumber(out, stats.cpuTime);
+        out << ", \"peak_rss_kb\": " << stats.peakRSS;
+        out << ", \"cost_evals\": " << stats.costEvals;
+        out << ", \"placeable_calls\": " << stats.placeableCalls;
+        out << ", \"moves_accepted\": " << stats.movesAccepted;
+        out << ", \"banks\": " << stats.banks;
+        out << ", \"ffs\": " << stats.numFFs;
+        out << ", \"legal\": " << (stats.legal ? "true" : "false");
+        out << ", \"cost\": ";
+        writeJsonNumber(out, stats.cost);
+        out << ", \"tns\": ";
+        writeJsonNumber(out, stats.components.tns);
+        out << ", \"power\": ";
+        writeJsonNumber(out, stats.components.power);
+        out << ", \"area\": ";
+        writeJsonNumber(out, stats.components.area);
+        out << ", \"bins_violated\": " << stats.components.bins << "}";
+    }
+    out << (_phaseStats.empty() ? "]" : "\n  ]");
+#ifdef HOTPATH_COUNTERS
+    out << ",\n  \"hotpath\": {";
+    for (int i = 0; i < NUM_HOT_COUNTERS; i++)
+    {
+        out << (i ? ", " : "") << "\"" << HotPath::name(HotCounter(i)) << "\": " << HotPath::total(HotCounter(i));
+    }
+    out << "}";
+#endif
+    out << "\n}\n";
+}
+
+void Solver::dump_best(std::string filename) const
+{
+    TRACE_SCOPE("dump_best");
+    std::ofstream out(filename, std::ios::binary);
+    writeSnapshot(_bestSnapshot, out);
+}
@@ -0,0 +1,226 @@
+#include "Sweep.h"
+#include "Solver.h"
+#include "HyperParams.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <sys/wait.h>
+#include <unistd.h>
+
+Sweep::Sweep(Solver* solver, const std::string& outputFile, int jobs, double timeBudget)
+{
+    _solver = solver;
+    _outputFile = outputFile;
+    _jobs = std::max(jobs, 1);
+    _timeBudget = timeBudget;
+}
+
+bool Sweep::load(const std::string& filename)
+{
+    std::ifstream in(filename);
+    if (!in)
+    {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line))
+    {
+        std::string settings = line.substr(0, line.find('#'));
+        if (settings.find_first_not_of(" \t\r") == std::string::npos)
+        {
+            continue;
+        }
+        _configs.push_back(Config{settings, -1, -1, false, -1, 0, ""});
+    }
+    if (_configs.empty())
+    {
+        std::cerr << "Error: No configuration in " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::string Sweep::configOutput(size_t idx) const
+{
+    return _outputFile + "." + std::to_string(idx);
+}
+
+/*
+Fork the child of a configuration, the parent keeps the read end of its result pipe
+*/
+bool Sweep::start(size_t idx)
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        std::cerr << "Error: Cannot create the pipe of configuration " << idx << std::endl;
+        return false;
+    }
+    // the child would write the buffered output again
+    std::cout.flush();
+    std::cerr.flush();
+    const int pid = fork();
+    if (pid < 0)
+    {
+        std::cerr << "Error: Cannot fork configuration " << idx << std::endl;
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (pid == 0)
+    {
+        close(fds[0]);
+        solveConfig(idx, fds[1]);
+    }
+    close(fds[1]);
+    _configs[idx].pid = pid;
+    _configs[idx].pipe = fds[0];
+    return true;
+}
+
+/*
+Runs in the child, solves with the settings of the configuration and writes "cost time best_phase" to the pipe
+*/
+void Sweep::solveConfig(size_t idx, int pipe)
+{
+    std::cout.rdbuf(nullptr);
+    if (!HyperParams::setAll(_configs[idx].settings))
+    {
+        _exit(1);
+    }
+    auto start = std::chrono::steady_clock::now();
+    if (_timeBudget > 0)
+    {
+        _solver->setTimeBudget(_timeBudget, configOutput(idx));
+    }
+    _solver->solve();
+    _solver->dump_best(configOutput(idx));
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    char result[256];
+    const int length = std::snprintf(result, sizeof(result), "%.17g %.17g %s\n", _solver->getBestCost(), elapsed.count(), _solver->getBestPhase().c_str());
+    const bool written = length > 0 && write(pipe, result, std::min<size_t>(length, sizeof(result) - 1)) == length;
+    close(pipe);
+    _exit(written ? 0 : 1);
+}
+
+/*
+Read the result of a child that exited
+*/
+void Sweep::finish(size_t idx, int status)
+{
+    Config& config = _configs[idx];
+    std::string result;
+    char buffer[256];
+    ssize_t n;
+    while ((n = read(config.pipe, buffer, sizeof(buffer))) > 0)
+    {
+        result.append(buffer, n);
+    }
+    close(config.pipe);
+    config.pipe = -1;
+    std::istringstream in(result);
+    const bool parsed = bool(in >> config.cost >> config.time);
+    in >> config.bestPhase;
+    config.ok = WIFEXITED(status) && WEXITSTATUS(status) == 0 && parsed && config.cost >= 0;
+    if (!config.ok)
+    {
+        std::cerr << "Error: Configuration " << idx << " failed: " << config.settings << std::endl;
+        std::remove(configOutput(idx).c_str());
+    }
+}
+
+/*
+Return false if no configuration produced a placement
+*/
+bool Sweep::run()
+{
+    size_t next = 0;
+    int running = 0;
+    while (next < _configs.size() || running > 0)
+    {
+        while (running < _jobs && next < _configs.size())
+        {
+            if (start(next))
+            {
+                running++;
+            }
+            next++;
+        }
+        if (running == 0)
+        {
+            continue;
+        }
+        int status = 0;
+        const int pid = waitpid(-1, &status, 0);
+        if (pid < 0)
+        {
+            std::cerr << "Error: Lost the sweep children" << std::endl;
+            return false;
+        }
+        for (size_t i = 0; i < _configs.size(); i++)
+        {
+            if (_configs[i].pid == pid && _configs[i].pipe >= 0)
+            {
+                finish(i, status);
+                running--;
+                break;
+            }
+        }
+    }
+
+    int best = -1;
+    for (size_t i = 0; i < _configs.size(); i++)
+    {
+        if (_configs[i].ok && (best < 0 || _configs[i].cost < _configs[best].cost))
+        {
+            best = i;
+        }
+    }
+    if (best < 0)
+    {
+        std::cerr << "Error: No configuration of the sweep succeeded" << std::endl;
+        return false;
+    }
+    for (size_t i = 0; i < _configs.size(); i++)
+    {
+        if (_configs[i].ok && int(i) != best)
+        {
+            std::remove(configOutput(i).c_str());
+        }
+    }
+    return std::rename(configOutput(best).c_str(), _outputFile.c_str()) == 0;
+}
+
+void Sweep::print(std::ostream& out) const
+{
+    out << std::left << std::setw(6) << "#" << std::setw(24) << "cost" << std::setw(12) << "time" << std::setw(20) << "best phase" << "settings\n";
+    int best = -1;
+    for (size_t i = 0; i < _configs.size(); i++)
+    {
+        const Config& config = _configs[i];
+        out << std::setw(6) << i;
+        if (config.ok)
+        {
+            out << std::setw(24) << std::setprecision(12) << config.cost << std::setw(12) << std::setprecision(4) << config.time << std::setw(20) << config.bestPhase;
+            if (best < 0 || config.cost < _configs[best].cost)
+            {
+                best = i;
+            }
+        }
+        else
+        {
+            out << std::setw(56) << "failed";
+        }
+        out << config.settings << "\n";
+    }
+    out << std::right;
+    if (best >= 0)
+    {
+        out << "Best: #" << best << " " << _configs[best].settings << "\n";
+    }
+}
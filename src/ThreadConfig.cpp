@@ -0,0 +1,255 @@
+#include "ThreadConfig.h"
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace
+{
+
+struct Schedule
+{
+    std::string kind;
+    // 0 for the default chunk of the kind
+    int chunk;
+};
+
+int numThreads = 4;
+std::string threadBind;
+bool deterministicSums = false;
+// the loops of the debank and FD phases are uneven, the banking and legalize ones are not
+std::map<std::string, Schedule> schedules = {
+    {"debank", {"dynamic", 0}},
+    {"gp", {"static", 0}},
+    {"fd", {"dynamic", 0}},
+    {"banking", {"static", 0}},
+    {"legalize", {"static", 0}},
+    {"default", {"static", 0}},
+};
+
+/*
+Parse "kind[,chunk]"
+*/
+bool parseSchedule(const std::string& text, Schedule& schedule)
+{
+    const size_t comma = text.find(',');
+    schedule.kind = text.substr(0, comma);
+    schedule.chunk = 0;
+    if (schedule.kind != "static" && schedule.kind != "dynamic" && schedule.kind != "guided" && schedule.kind != "auto")
+    {
+        std::cerr << "Error: Unknown schedule: " << schedule.kind << std::endl;
+        return false;
+    }
+    if (comma != std::string::npos)
+    {
+        char* end = nullptr;
+        const std::string chunk = text.substr(comma + 1);
+        schedule.chunk = std::strtol(chunk.c_str(), &end, 10);
+        if (chunk.empty() || *end != '\0' || schedule.chunk < 0)
+        {
+            std::cerr << "Error: Invalid schedule chunk: " << chunk << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+int ThreadConfig::threads()
+{
+    return numThreads;
+}
+
+bool ThreadConfig::setThreads(int n)
+{
+    if (n < 0)
+    {
+        std::cerr << "Error: Invalid number of threads: " << n << std::endl;
+        return false;
+    }
+    if (n == 0)
+    {
+#ifdef _OPENMP
+        n = omp_get_num_procs();
+#else
+        n = 1;
+#endif
+    }
+    numThreads = n;
+    return true;
+}
+
+/*
+A phase not in the spec keeps its schedule, a schedule without a phase applies to all of them
+*/
+bool ThreadConfig::setSchedule(const std::string& spec)
+{
+    std::map<std::string, Schedule> parsed = schedules;
+    std::stringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, ';'))
+    {
+        if (item.empty())
+        {
+            continue;
+        }
+        const size_t eq = item.find('=');
+        Schedule schedule;
+        if (!parseSchedule(eq == std::string::npos ? item : item.substr(eq + 1), schedule))
+        {
+            return false;
+        }
+        if (eq == std::string::npos)
+        {
+            for (auto& entry : parsed)
+            {
+                entry.second = schedule;
+            }
+            continue;
+        }
+        const std::string phase = item.substr(0, eq);
+        if (parsed.find(phase) == parsed.end())
+        {
+            std::cerr << "Error: Unknown phase in schedule: " << phase << std::endl;
+            return false;
+        }
+        parsed[phase] = schedule;
+    }
+    schedules = parsed;
+    return true;
+}
+
+bool ThreadConfig::setBind(const std::string& bind)
+{
+    if (bind != "close" && bind != "spread" && bind != "master" && bind != "false")
+    {
+        std::cerr << "Error: Unknown thread binding: " << bind << std::endl;
+        return false;
+    }
+    threadBind = bind;
+    return true;
+}
+
+bool ThreadConfig::loadEnvironment()
+{
+    const char* threadsEnv = std::getenv("SOLVER_THREADS");
+    if (threadsEnv != nullptr)
+    {
+        char* end = nullptr;
+        const long n = std::strtol(threadsEnv, &end, 10);
+        if (*threadsEnv == '\0' || *end != '\0' || !setThreads(n))
+        {
+            std::cerr << "Error: Invalid SOLVER_THREADS: " << threadsEnv << std::endl;
+            return false;
+        }
+    }
+    const char* scheduleEnv = std::getenv("SOLVER_SCHEDULE");
+    if (scheduleEnv != nullptr && !setSchedule(scheduleEnv))
+    {
+        return false;
+    }
+    const char* bindEnv = std::getenv("SOLVER_BIND");
+    if (bindEnv != nullptr && !setBind(bindEnv))
+    {
+        return false;
+    }
+    const char* deterministicEnv = std::getenv("SOLVER_DETERMINISTIC");
+    if (deterministicEnv != nullptr)
+    {
+        const std::string value = deterministicEnv;
+        if (value != "0" && value != "1")
+        {
+            std::cerr << "Error: Invalid SOLVER_DETERMINISTIC: " << value << std::endl;
+            return false;
+        }
+        setDeterministic(value == "1");
+    }
+    return true;
+}
+
+/*
+Returns only if no binding was asked for, it is already in effect or the restart failed
+*/
+void ThreadConfig::rebind(char* argv[])
+{
+#ifdef _OPENMP
+    if (threadBind.empty())
+    {
+        return;
+    }
+    const char* current = std::getenv("OMP_PROC_BIND");
+    if (current != nullptr && threadBind == current)
+    {
+        return;
+    }
+    setenv("OMP_PROC_BIND", threadBind.c_str(), 1);
+    if (std::getenv("OMP_PLACES") == nullptr)
+    {
+        setenv("OMP_PLACES", "cores", 1);
+    }
+    std::cout.flush();
+    execv("/proc/self/exe", argv);
+    std::cerr << "Warning: Could not restart to bind the threads, running unbound" << std::endl;
+#else
+    (void)argv;
+#endif
+}
+
+void ThreadConfig::applySchedule(const std::string& phase)
+{
+#ifdef _OPENMP
+    auto it = schedules.find(phase);
+    const Schedule& schedule = it != schedules.end() ? it->second : schedules["default"];
+    omp_sched_t kind = omp_sched_static;
+    if (schedule.kind == "dynamic")
+    {
+        kind = omp_sched_dynamic;
+    }
+    else if (schedule.kind == "guided")
+    {
+        kind = omp_sched_guided;
+    }
+    else if (schedule.kind == "auto")
+    {
+        kind = omp_sched_auto;
+    }
+    omp_set_schedule(kind, schedule.chunk);
+#else
+    (void)phase;
+#endif
+}
+
+void ThreadConfig::setDeterministic(bool deterministic)
+{
+    deterministicSums = deterministic;
+}
+
+bool ThreadConfig::deterministic()
+{
+    return deterministicSums;
+}
+
+void ThreadConfig::print(std::ostream& out)
+{
+    out << "Threads: " << numThreads;
+    if (deterministicSums)
+    {
+        out << " (deterministic)";
+    }
+    out << ", bind: " << (threadBind.empty() ? "default" : threadBind);
+    out << ", schedule:";
+    for (const auto& entry : schedules)
+    {
+        out << " " << entry.first << "=" << entry.second.kind;
+        if (entry.second.chunk > 0)
+        {
+            out << "," << entry.second.chunk;
+        }
+    }
+    out << std::endl;
+}
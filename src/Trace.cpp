@@ -0,0 +1,171 @@
+#include "Trace.h"
+#include "OutputBuffer.h"
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+
+struct ThreadTrace
+{
+    int tid;
+    std::vector<TraceEvent> events;
+    // total number of events recorded, the ring holds the last events.size() of them
+    size_t recorded;
+};
+
+std::chrono::steady_clock::time_point traceStart;
+size_t traceCapacity = 0;
+std::mutex traceMutex;
+std::vector<std::unique_ptr<ThreadTrace>> threadTraces;
+std::deque<std::string> traceLabels;
+thread_local ThreadTrace* localTrace = nullptr;
+
+/*
+Give the calling thread its ring buffer, the buffers outlive the threads so they can be written at exit
+*/
+ThreadTrace* registerThread()
+{
+    std::lock_guard<std::mutex> lock(traceMutex);
+    std::unique_ptr<ThreadTrace> trace(new ThreadTrace());
+    trace->tid = threadTraces.size();
+    trace->events.resize(traceCapacity);
+    trace->recorded = 0;
+    localTrace = trace.get();
+    threadTraces.push_back(std::move(trace));
+    return localTrace;
+}
+
+/*
+Append a time in ns as the microseconds of the trace format
+*/
+void appendMicros(OutputBuffer& buf, int64_t ns)
+{
+    buf.appendInt(ns / 1000);
+    const int frac = ns % 1000;
+    buf.append('.');
+    buf.append(char('0' + frac / 100));
+    buf.append(char('0' + frac / 10 % 10));
+    buf.append(char('0' + frac % 10));
+}
+
+void appendJsonString(OutputBuffer& buf, const char* s)
+{
+    buf.append('"');
+    for (; *s; s++)
+    {
+        if (*s == '"' || *s == '\\')
+        {
+            buf.append('\\');
+        }
+        if (static_cast<unsigned char>(*s) >= 0x20)
+        {
+            buf.append(*s);
+        }
+    }
+    buf.append('"');
+}
+
+}
+
+bool Trace::_enabled = false;
+
+/*
+Start recording, the calling thread gets id 0
+*/
+void Trace::enable(size_t eventsPerThread)
+{
+    if (_enabled)
+    {
+        return;
+    }
+    traceCapacity = eventsPerThread > 0 ? eventsPerThread : 1;
+    traceStart = std::chrono::steady_clock::now();
+    registerThread();
+    _enabled = true;
+}
+
+int64_t Trace::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - traceStart).count();
+}
+
+void Trace::record(const char* name, int64_t begin, int64_t end)
+{
+    ThreadTrace* trace = localTrace ? localTrace : registerThread();
+    trace->events[trace->recorded % trace->events.size()] = TraceEvent{name, begin, end};
+    trace->recorded++;
+}
+
+const char* Trace::label(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(traceMutex);
+    for (auto& label : traceLabels)
+    {
+        if (label == name)
+        {
+            return label.c_str();
+        }
+    }
+    traceLabels.push_back(name);
+    return traceLabels.back().c_str();
+}
+
+bool Trace::write(const std::string& filename)
+{
+    std::ofstream out(filename, std::ios::binary);
+    if (!out)
+    {
+        std::cerr << "Error: cannot open trace file " << filename << std::endl;
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(traceMutex);
+    OutputBuffer buf;
+    size_t dropped = 0;
+    buf.append("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    buf.append("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"solver\"}}");
+    for (auto& trace : threadTraces)
+    {
+        buf.append(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":");
+        buf.appendInt(trace->tid);
+        buf.append(",\"args\":{\"name\":\"");
+        buf.append(trace->tid == 0 ? "main" : "worker ");
+        if (trace->tid != 0)
+        {
+            buf.appendInt(trace->tid);
+        }
+        buf.append("\"}}");
+
+        const size_t capacity = trace->events.size();
+        const size_t count = std::min(trace->recorded, capacity);
+        dropped += trace->recorded - count;
+        for (size_t i = trace->recorded - count; i < trace->recorded; i++)
+        {
+            const TraceEvent& event = trace->events[i % capacity];
+            buf.append(",\n{\"name\":");
+            appendJsonString(buf, event.name);
+            buf.append(",\"ph\":\"X\",\"pid\":1,\"tid\":");
+            buf.appendInt(trace->tid);
+            buf.append(",\"ts\":");
+            appendMicros(buf, event.begin);
+            buf.append(",\"dur\":");
+            appendMicros(buf, event.end - event.begin);
+            buf.append('}');
+        }
+    }
+    buf.append("\n],\"otherData\":{\"dropped_events\":");
+    buf.appendInt(dropped);
+    buf.append("}}\n");
+    buf.writeTo(out);
+    if (dropped > 0)
+    {
+        std::cerr << "Warning: " << dropped << " trace events were overwritten, only the last " << traceCapacity << " of each thread are kept" << std::endl;
+    }
+    return true;
+}
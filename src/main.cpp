@@ -1,28 +1,186 @@
 #include <iostream>
 #include <string>
+#include <vector>
+#include <cstdlib>
 #include "Solver.h"
+#include "Trace.h"
+#include "HotPath.h"
+#include "ThreadConfig.h"
+#include "HyperParams.h"
+#include "Sweep.h"
 
 int main(int argc, char* argv[])
 {
     std::ios::sync_with_stdio(false);
     std::cin.tie(nullptr);
-    // format ./$binary_name <input.txt> <output.txt>
-    if (argc != 3)
+    // format ./$binary_name <input.txt> <output.txt> [--time-budget <seconds>] [--report <report.json>] [--trace <trace.json>] [--verify] [--timing-check <fraction>] [--threads <n>] [--schedule <spec>] [--bind <close|spread|master|false>] [--deterministic] [--config <params.txt>] [--set <name=value>] [--sweep <sweep.txt>] [--jobs <n>] [--print-params]
+    std::vector<std::string> files;
+    double time_budget = 0;
+    std::string report_file;
+    std::string trace_file;
+    bool verify = false;
+    double timing_check = 0;
+    // the environment (SOLVER_THREADS, SOLVER_SCHEDULE, SOLVER_BIND) first, the flags override it
+    if (!ThreadConfig::loadEnvironment())
     {
-        std::cerr << "Usage: " << argv[0] << " <input.txt> <output.txt>" << std::endl;
         return 1;
     }
-    std::string input_file = argv[1];
-    std::string output_file = argv[2];
+    bool threadsOk = true;
+    // hyper parameters are set in the order of the flags, a later one overrides an earlier one
+    bool paramsOk = true;
+    std::string sweep_file;
+    int jobs = 1;
+    bool print_params = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--time-budget" && i + 1 < argc)
+        {
+            time_budget = std::atof(argv[++i]);
+        }
+        else if (arg == "--report" && i + 1 < argc)
+        {
+            report_file = argv[++i];
+        }
+        else if (arg == "--verify")
+        {
+            verify = true;
+        }
+        else if (arg == "--timing-check" && i + 1 < argc)
+        {
+            timing_check = std::atof(argv[++i]);
+        }
+        else if (arg == "--trace" && i + 1 < argc)
+        {
+            trace_file = argv[++i];
+        }
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            threadsOk = ThreadConfig::setThreads(std::atoi(argv[++i])) && threadsOk;
+        }
+        else if (arg == "--schedule" && i + 1 < argc)
+        {
+            threadsOk = ThreadConfig::setSchedule(argv[++i]) && threadsOk;
+        }
+        else if (arg == "--bind" && i + 1 < argc)
+        {
+            threadsOk = ThreadConfig::setBind(argv[++i]) && threadsOk;
+        }
+        else if (arg == "--deterministic")
+        {
+            ThreadConfig::setDeterministic(true);
+        }
+        else if (arg == "--config" && i + 1 < argc)
+        {
+            paramsOk = HyperParams::load(argv[++i]) && paramsOk;
+        }
+        else if (arg == "--set" && i + 1 < argc)
+        {
+            paramsOk = HyperParams::set(argv[++i]) && paramsOk;
+        }
+        else if (arg == "--print-params")
+        {
+            print_params = true;
+        }
+        else if (arg == "--sweep" && i + 1 < argc)
+        {
+            sweep_file = argv[++i];
+        }
+        else if (arg == "--jobs" && i + 1 < argc)
+        {
+            jobs = std::atoi(argv[++i]);
+        }
+        else
+        {
+            files.push_back(arg);
+        }
+    }
+    // the current values, in the format of a config file
+    if (print_params && paramsOk)
+    {
+        HyperParams::print(std::cout);
+        return 0;
+    }
+    if (files.size() != 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <input.txt> <output.txt> [--time-budget <seconds>] [--report <report.json>] [--trace <trace.json>] [--verify] [--timing-check <fraction>] [--threads <n>] [--schedule <spec>] [--bind <close|spread|master|false>] [--deterministic] [--config <params.txt>] [--set <name=value>] [--sweep <sweep.txt>] [--jobs <n>] [--print-params]" << std::endl;
+        return 1;
+    }
+    if (!threadsOk || !paramsOk)
+    {
+        return 1;
+    }
+    ThreadConfig::rebind(argv);
+    if (ThreadConfig::deterministic() && time_budget > 0)
+    {
+        std::cerr << "Warning: With --time-budget the phases are cut by the clock, the results still depend on the timing" << std::endl;
+    }
+    ThreadConfig::print(std::cout);
+    std::string input_file = files[0];
+    std::string output_file = files[1];
+    if (!sweep_file.empty())
+    {
+        if (!report_file.empty() || !trace_file.empty() || verify || timing_check > 0)
+        {
+            std::cerr << "Warning: --report, --trace, --verify and --timing-check are ignored by --sweep" << std::endl;
+        }
+        Solver* solver = new Solver();
+        Sweep sweep(solver, output_file, jobs, time_budget);
+        if (!sweep.load(sweep_file))
+        {
+            delete solver;
+            return 1;
+        }
+        solver->parse_input(input_file);
+        const bool ok = sweep.run();
+        sweep.print(std::cout);
+        delete solver;
+        return ok ? 0 : 1;
+    }
+    if (!trace_file.empty())
+    {
+        Trace::enable();
+    }
     Solver* solver = new Solver();
+    if (time_budget > 0)
+    {
+        solver->setTimeBudget(time_budget, output_file);
+    }
+    solver->setTimingCheck(timing_check);
 
     solver->parse_input(input_file);
+    if (verify && !solver->setVerify(input_file))
+    {
+        delete solver;
+        return 1;
+    }
     solver->solve();
     // TO BE DELETED
     solver->check();
     solver->report();
+#ifdef HOTPATH_COUNTERS
+    HotPath::print(std::cout);
+#endif
     solver->dump_best(output_file);
+    if (!report_file.empty())
+    {
+        solver->writeReport(report_file);
+    }
+    if (!trace_file.empty())
+    {
+        Trace::write(trace_file);
+    }
 
+    const int verifyFailures = solver->getVerifyFailures();
+    if (verifyFailures > 0)
+    {
+        std::cerr << "Verification failed after " << verifyFailures << " phases" << std::endl;
+    }
+    const int timingCheckFailures = solver->getTimingCheckFailures();
+    if (timingCheckFailures > 0)
+    {
+        std::cerr << "Timing check failed after " << timingCheckFailures << " phases" << std::endl;
+    }
     delete solver;
-    return 0;
+    return (verifyFailures > 0 || timingCheckFailures > 0) ? 1 : 0;
 }
\ No newline at end of file
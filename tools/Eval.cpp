@@ -0,0 +1,51 @@
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include "Evaluator.h"
+
+/*
+Standalone evaluator, re-derives the cost of an output and checks its mapping and placement.
+Exit status is 0 if the output has no errors.
+*/
+int main(int argc, char* argv[])
+{
+    std::ios::sync_with_stdio(false);
+    // format ./EVAL <input.txt> <output.txt> [--max-errors <n>]
+    std::string files[2];
+    int numFiles = 0;
+    int maxErrors = 10;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--max-errors" && i + 1 < argc)
+        {
+            maxErrors = std::atoi(argv[++i]);
+        }
+        else if (numFiles < 2)
+        {
+            files[numFiles++] = arg;
+        }
+        else
+        {
+            numFiles++;
+        }
+    }
+    if (numFiles != 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <input.txt> <output.txt> [--max-errors <n>]" << std::endl;
+        return 2;
+    }
+    Evaluator evaluator;
+    evaluator.setMaxMessages(maxErrors);
+    if (!evaluator.loadInput(files[0]))
+    {
+        return 2;
+    }
+    EvalResult result;
+    if (!evaluator.evaluate(files[1], result))
+    {
+        return 2;
+    }
+    evaluator.print(result, std::cout);
+    return result.ok() ? 0 : 1;
+}
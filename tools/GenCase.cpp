@@ -0,0 +1,618 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include "OutputBuffer.h"
+
+/*
+Synthetic testcase generator in the contest input format.
+Cells are placed on a grid of slots in serpentine order and nets connect cells created close to each other,
+so nets stay local and the timing is meaningful at any size. The same options and seed give the same case.
+*/
+
+struct GenOptions
+{
+    long numFFs = 1000;
+    long numGates = -1;             // 2 * numFFs if negative
+    int numClkDomains = 2;
+    std::vector<int> bits = {1, 2, 4};
+    int ffLibsPerBit = 2;
+    int numGateLibs = 2;
+    int siteWidth = 50;
+    int rowHeight = 200;
+    double util = 0.25;             // cell area / die area
+    int binSlots = 4;               // bin size in slots
+    double binMaxUtil = 60;
+    long locality = 64;             // drivers are picked among the last drivers created, 0 for any
+    double slackMean = -0.5;
+    double slackStddev = 1.0;
+    double displacementDelay = 0.001;
+    double alpha = 1;
+    double beta = 5;
+    double gamma = 0.0001;
+    double lambda = 100;
+    unsigned seed = 1;
+    std::string output;
+};
+
+struct GenLib
+{
+    std::string name;
+    int bit;
+    int width;
+    int height;
+    double power;
+    double qDelay;
+    int numInputs;                  // gates only
+};
+
+// driver of a net: an input port, the Q pin of an FF or the output of a gate
+struct Driver
+{
+    char kind;                      // 'i', 'q', 'g'
+    long inst;
+    int pin;
+};
+
+static void usage(const char* prog)
+{
+    std::cerr << "Usage: " << prog << " -o <output.txt> [options]\n"
+              << "  --ffs <n>              number of FF instances (1000)\n"
+              << "  --gates <n>            number of gate instances (2 * ffs)\n"
+              << "  --clk-domains <n>      number of clock nets (2)\n"
+              << "  --bits <b,b,...>       bit widths of the FF library (1,2,4)\n"
+              << "  --ff-libs <n>          FF lib cells per bit width (2)\n"
+              << "  --gate-libs <n>        gate lib cells, with 1 to 3 inputs (2)\n"
+              << "  --site-width <n>       placement site width (50)\n"
+              << "  --row-height <n>       placement row height (200)\n"
+              << "  --util <x>             cell area over die area (0.25)\n"
+              << "  --bin-slots <n>        bin size in cell slots (4)\n"
+              << "  --bin-max-util <x>     BinMaxUtil in percent (60)\n"
+              << "  --locality <n>         pick drivers among the last n drivers, 0 for any (64)\n"
+              << "  --slack-mean <x>       mean of the D pin slacks (-0.5)\n"
+              << "  --slack-stddev <x>     standard deviation of the D pin slacks (1.0)\n"
+              << "  --disp-delay <x>       DisplacementDelay (0.001)\n"
+              << "  --alpha/--beta/--gamma/--lambda <x>  cost weights (1, 5, 0.0001, 100)\n"
+              << "  --seed <n>             random seed (1)" << std::endl;
+}
+
+static bool parseArgs(int argc, char* argv[], GenOptions& opt)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            std::cerr << "Error: missing value for " << arg << std::endl;
+            return false;
+        }
+        std::string value = argv[++i];
+        if (arg == "-o") opt.output = value;
+        else if (arg == "--ffs") opt.numFFs = std::atol(value.c_str());
+        else if (arg == "--gates") opt.numGates = std::atol(value.c_str());
+        else if (arg == "--clk-domains") opt.numClkDomains = std::atoi(value.c_str());
+        else if (arg == "--ff-libs") opt.ffLibsPerBit = std::atoi(value.c_str());
+        else if (arg == "--gate-libs") opt.numGateLibs = std::atoi(value.c_str());
+        else if (arg == "--site-width") opt.siteWidth = std::atoi(value.c_str());
+        else if (arg == "--row-height") opt.rowHeight = std::atoi(value.c_str());
+        else if (arg == "--util") opt.util = std::atof(value.c_str());
+        else if (arg == "--bin-slots") opt.binSlots = std::atoi(value.c_str());
+        else if (arg == "--bin-max-util") opt.binMaxUtil = std::atof(value.c_str());
+        else if (arg == "--locality") opt.locality = std::atol(value.c_str());
+        else if (arg == "--slack-mean") opt.slackMean = std::atof(value.c_str());
+        else if (arg == "--slack-stddev") opt.slackStddev = std::atof(value.c_str());
+        else if (arg == "--disp-delay") opt.displacementDelay = std::atof(value.c_str());
+        else if (arg == "--alpha") opt.alpha = std::atof(value.c_str());
+        else if (arg == "--beta") opt.beta = std::atof(value.c_str());
+        else if (arg == "--gamma") opt.gamma = std::atof(value.c_str());
+        else if (arg == "--lambda") opt.lambda = std::atof(value.c_str());
+        else if (arg == "--seed") opt.seed = std::strtoul(value.c_str(), nullptr, 10);
+        else if (arg == "--bits")
+        {
+            opt.bits.clear();
+            size_t start = 0;
+            while (start <= value.size())
+            {
+                size_t end = value.find(',', start);
+                if (end == std::string::npos)
+                    end = value.size();
+                if (end > start)
+                    opt.bits.push_back(std::atoi(value.substr(start, end - start).c_str()));
+                start = end + 1;
+            }
+        }
+        else
+        {
+            std::cerr << "Error: unknown option " << arg << std::endl;
+            return false;
+        }
+    }
+    if (opt.output.empty() || opt.numFFs <= 0 || opt.numClkDomains <= 0 || opt.ffLibsPerBit <= 0 || opt.numGateLibs <= 0
+        || opt.siteWidth <= 0 || opt.rowHeight <= 0 || opt.util <= 0 || opt.binSlots <= 0 || opt.bits.empty()
+        || std::find(opt.bits.begin(), opt.bits.end(), 1) == opt.bits.end())
+    {
+        std::cerr << "Error: an output file, positive sizes and a 1-bit FF are required" << std::endl;
+        return false;
+    }
+    if (opt.numGates < 0)
+    {
+        opt.numGates = 2 * opt.numFFs;
+    }
+    return true;
+}
+
+static void appendDouble(OutputBuffer& buf, double value, const char* format)
+{
+    char tmp[64];
+    int n = std::snprintf(tmp, sizeof(tmp), format, value);
+    buf.append(tmp, n);
+}
+
+static void appendPinName(OutputBuffer& buf, const char* prefix, int bit, int idx)
+{
+    buf.append(prefix);
+    if (bit > 1)
+    {
+        buf.appendInt(idx);
+    }
+}
+
+static void appendDriver(OutputBuffer& buf, const Driver& d, const std::vector<int>& ffLib, const std::vector<GenLib>& ffLibs)
+{
+    if (d.kind == 'i')
+    {
+        buf.append("in", 2);
+        buf.appendInt(d.inst);
+    }
+    else if (d.kind == 'q')
+    {
+        buf.append('F');
+        buf.appendInt(d.inst);
+        buf.append('/');
+        appendPinName(buf, "Q", ffLibs[ffLib[d.inst]].bit, d.pin);
+    }
+    else
+    {
+        buf.append('G');
+        buf.appendInt(d.inst);
+        buf.append("/OUT", 4);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    GenOptions opt;
+    if (!parseArgs(argc, argv, opt))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+    std::mt19937_64 rng(opt.seed);
+    auto uniform = [&rng](long n) { return long(std::uniform_int_distribution<long>(0, n - 1)(rng)); };
+    const int sw = opt.siteWidth;
+    const int rh = opt.rowHeight;
+    const int numInputs = 4;
+    const int numOutputs = 4;
+
+    // libraries, sizes are multiples of the site width and the row height
+    std::vector<GenLib> ffLibs;
+    for (int bit : opt.bits)
+    {
+        for (int v = 0; v < opt.ffLibsPerBit; v++)
+        {
+            GenLib lib;
+            lib.name = "FF" + std::to_string(bit) + "_" + std::to_string(v);
+            lib.bit = bit;
+            lib.width = sw * (4 + 2 * v + (bit > 1 ? 3 * bit : 4));
+            lib.height = rh * ((bit + 1) / 2);
+            lib.power = (10.0 - 1.5 * v) * (0.6 + 0.4 * bit);
+            lib.qDelay = 1.0 + 0.2 * v + 0.1 * bit;
+            lib.numInputs = 0;
+            ffLibs.push_back(lib);
+        }
+    }
+    std::vector<GenLib> gateLibs;
+    for (int v = 0; v < opt.numGateLibs; v++)
+    {
+        GenLib lib;
+        lib.name = "G" + std::to_string(v);
+        lib.bit = 0;
+        lib.numInputs = 1 + v % 3;
+        lib.width = sw * (2 + 2 * lib.numInputs);
+        lib.height = rh;
+        lib.power = 1.0 + 0.5 * v;
+        lib.qDelay = 0;
+        gateLibs.push_back(lib);
+    }
+    int slotW = 0;
+    int slotH = 0;
+    for (auto& lib : ffLibs)
+    {
+        slotW = std::max(slotW, lib.width);
+        slotH = std::max(slotH, lib.height);
+    }
+    for (auto& lib : gateLibs)
+    {
+        slotW = std::max(slotW, lib.width);
+        slotH = std::max(slotH, lib.height);
+    }
+
+    // cells in creation order, FFs and gates interleaved, and the die sized by the utilization
+    const long numCells = opt.numFFs + opt.numGates;
+    std::vector<char> isFF(numCells, 0);
+    std::fill(isFF.begin(), isFF.begin() + opt.numFFs, 1);
+    std::shuffle(isFF.begin(), isFF.end(), rng);
+    std::vector<int> ffLib(opt.numFFs);
+    std::vector<int> gateLib(opt.numGates);
+    double cellArea = 0;
+    for (long i = 0; i < opt.numFFs; i++)
+    {
+        // most FFs are 1-bit, as in the contest cases
+        const GenLib* lib;
+        do
+        {
+            ffLib[i] = uniform(ffLibs.size());
+            lib = &ffLibs[ffLib[i]];
+        } while (lib->bit > 2 && uniform(4) != 0);
+        cellArea += double(lib->width) * lib->height;
+    }
+    for (long i = 0; i < opt.numGates; i++)
+    {
+        gateLib[i] = uniform(gateLibs.size());
+        cellArea += double(gateLibs[gateLib[i]].width) * gateLibs[gateLib[i]].height;
+    }
+    const double dieArea = cellArea / std::min(opt.util, 0.9);
+    long cols = std::max(1L, long(std::sqrt(dieArea) / slotW));
+    long rows = std::max(1L, long(dieArea / (double(cols) * slotW * slotH)));
+    while (cols * rows < numCells)
+    {
+        rows++;
+    }
+    const long dieW = cols * slotW;
+    const long dieH = rows * slotH;
+
+    // slots in serpentine order, each cell takes the next slot with a small random skip
+    const long spare = cols * rows - numCells;
+    std::vector<long> cellX(numCells);
+    std::vector<long> cellY(numCells);
+    long slot = 0;
+    long skipped = 0;
+    for (long c = 0; c < numCells; c++)
+    {
+        if (skipped < spare && uniform(numCells) < spare)
+        {
+            slot++;
+            skipped++;
+        }
+        const long r = slot / cols;
+        const long k = slot % cols;
+        cellX[c] = ((r % 2 == 0) ? k : cols - 1 - k) * slotW;
+        cellY[c] = r * slotH;
+        slot++;
+    }
+
+    // connectivity, gate inputs and D pins are driven by a driver created recently
+    std::vector<Driver> drivers;
+    for (int i = 0; i < numInputs; i++)
+    {
+        drivers.push_back(Driver{'i', i, 0});
+    }
+    std::vector<std::vector<std::pair<long, int>>> gateFanin(opt.numGates);
+    std::vector<long> ffDriverPos(opt.numFFs);
+    auto pickDriver = [&](long pos) {
+        const long window = (opt.locality > 0) ? std::min<long>(opt.locality, pos) : pos;
+        return pos - 1 - uniform(window);
+    };
+    long ffIdx = 0;
+    long gateIdx = 0;
+    std::vector<long> instOfCell(numCells);
+    for (long c = 0; c < numCells; c++)
+    {
+        if (isFF[c])
+        {
+            instOfCell[c] = ffIdx;
+            ffDriverPos[ffIdx] = drivers.size();
+            for (int b = 0; b < ffLibs[ffLib[ffIdx]].bit; b++)
+            {
+                drivers.push_back(Driver{'q', ffIdx, b});
+            }
+            ffIdx++;
+        }
+        else
+        {
+            instOfCell[c] = gateIdx;
+            for (int p = 0; p < gateLibs[gateLib[gateIdx]].numInputs; p++)
+            {
+                gateFanin[gateIdx].push_back(std::make_pair(pickDriver(drivers.size()), p));
+            }
+            drivers.push_back(Driver{'g', gateIdx, 0});
+            gateIdx++;
+        }
+    }
+    // sinks of each driver: gate input (inst, pin), D pin (-1 - ff, bit) or output port (-1 - numFFs - port)
+    std::vector<std::vector<std::pair<long, int>>> sinks(drivers.size());
+    for (long g = 0; g < opt.numGates; g++)
+    {
+        for (auto& fanin : gateFanin[g])
+        {
+            sinks[fanin.first].push_back(std::make_pair(g, fanin.second));
+        }
+    }
+    for (long f = 0; f < opt.numFFs; f++)
+    {
+        for (int b = 0; b < ffLibs[ffLib[f]].bit; b++)
+        {
+            // D pins may also be driven by logic created after the FF
+            const long pos = std::min<long>(drivers.size(), ffDriverPos[f] + 1 + uniform(std::max<long>(1, opt.locality / 2)));
+            sinks[pickDriver(pos)].push_back(std::make_pair(-1 - f, b));
+        }
+    }
+    for (int o = 0; o < numOutputs; o++)
+    {
+        sinks[pickDriver(drivers.size())].push_back(std::make_pair(-1 - opt.numFFs - o, 0));
+    }
+
+    std::ofstream out(opt.output, std::ios::binary);
+    if (!out.good())
+    {
+        std::cerr << "Error opening file: " << opt.output << std::endl;
+        return 1;
+    }
+    OutputBuffer buf;
+    const size_t flushSize = 1 << 22;
+    auto flush = [&]() {
+        if (buf.size() >= flushSize)
+        {
+            buf.writeTo(out);
+            buf.clear();
+        }
+    };
+
+    appendDouble(buf, opt.alpha, "Alpha %g\n");
+    appendDouble(buf, opt.beta, "Beta %g\n");
+    appendDouble(buf, opt.gamma, "Gamma %g\n");
+    appendDouble(buf, opt.lambda, "Lambda %g\n");
+    buf.append("DieSize 0 0 ");
+    buf.appendInt(dieW);
+    buf.append(' ');
+    buf.appendInt(dieH);
+    buf.append("\nNumInput ");
+    buf.appendInt(numInputs + 1);
+    buf.append('\n');
+    for (int i = 0; i < numInputs; i++)
+    {
+        buf.append("Input in");
+        buf.appendInt(i);
+        buf.append(" 0 ");
+        buf.appendInt((i + 1) * dieH / (numInputs + 2));
+        buf.append('\n');
+    }
+    buf.append("Input clk 0 ");
+    buf.appendInt((numInputs + 1) * dieH / (numInputs + 2));
+    buf.append("\nNumOutput ");
+    buf.appendInt(numOutputs);
+    buf.append('\n');
+    for (int o = 0; o < numOutputs; o++)
+    {
+        buf.append("Output out");
+        buf.appendInt(o);
+        buf.append(' ');
+        buf.appendInt(dieW);
+        buf.append(' ');
+        buf.appendInt((o + 1) * dieH / (numOutputs + 1));
+        buf.append('\n');
+    }
+    for (auto& lib : ffLibs)
+    {
+        buf.append("FlipFlop ");
+        buf.appendInt(lib.bit);
+        buf.append(' ');
+        buf.append(lib.name);
+        buf.append(' ');
+        buf.appendInt(lib.width);
+        buf.append(' ');
+        buf.appendInt(lib.height);
+        buf.append(' ');
+        buf.appendInt(2 * lib.bit + 1);
+        buf.append('\n');
+        const int pitch = lib.height / (lib.bit + 1);
+        for (int b = 0; b < lib.bit; b++)
+        {
+            buf.append("Pin ");
+            appendPinName(buf, "D", lib.bit, b);
+            buf.append(" 0 ");
+            buf.appendInt(pitch * (b + 1));
+            buf.append('\n');
+        }
+        for (int b = 0; b < lib.bit; b++)
+        {
+            buf.append("Pin ");
+            appendPinName(buf, "Q", lib.bit, b);
+            buf.append(' ');
+            buf.appendInt(lib.width - sw);
+            buf.append(' ');
+            buf.appendInt(pitch * (b + 1));
+            buf.append('\n');
+        }
+        buf.append("Pin CLK ");
+        buf.appendInt(lib.width / 2);
+        buf.append(" 0\n");
+    }
+    for (auto& lib : gateLibs)
+    {
+        buf.append("Gate ");
+        buf.append(lib.name);
+        buf.append(' ');
+        buf.appendInt(lib.width);
+        buf.append(' ');
+        buf.appendInt(lib.height);
+        buf.append(' ');
+        buf.appendInt(lib.numInputs + 1);
+        buf.append('\n');
+        for (int p = 0; p < lib.numInputs; p++)
+        {
+            buf.append("Pin IN");
+            buf.appendInt(p + 1);
+            buf.append(" 0 ");
+            buf.appendInt(lib.height * (p + 1) / (lib.numInputs + 1));
+            buf.append('\n');
+        }
+        buf.append("Pin OUT ");
+        buf.appendInt(lib.width - sw);
+        buf.append(' ');
+        buf.appendInt(lib.height / 2);
+        buf.append('\n');
+    }
+
+    buf.append("NumInstances ");
+    buf.appendInt(numCells);
+    buf.append('\n');
+    for (long c = 0; c < numCells; c++)
+    {
+        const long inst = instOfCell[c];
+        buf.append("Inst ");
+        buf.append(isFF[c] ? 'F' : 'G');
+        buf.appendInt(inst);
+        buf.append(' ');
+        buf.append(isFF[c] ? ffLibs[ffLib[inst]].name : gateLibs[gateLib[inst]].name);
+        buf.append(' ');
+        buf.appendInt(cellX[c]);
+        buf.append(' ');
+        buf.appendInt(cellY[c]);
+        buf.append('\n');
+        flush();
+    }
+
+    long numNets = opt.numClkDomains;
+    for (auto& s : sinks)
+    {
+        numNets += s.empty() ? 0 : 1;
+    }
+    buf.append("NumNets ");
+    buf.appendInt(numNets);
+    buf.append('\n');
+    long netId = 0;
+    for (size_t d = 0; d < drivers.size(); d++)
+    {
+        if (sinks[d].empty())
+            continue;
+        buf.append("Net n");
+        buf.appendInt(netId++);
+        buf.append(' ');
+        buf.appendInt(sinks[d].size() + 1);
+        buf.append("\nPin ");
+        appendDriver(buf, drivers[d], ffLib, ffLibs);
+        buf.append('\n');
+        for (auto& sink : sinks[d])
+        {
+            buf.append("Pin ");
+            if (sink.first >= 0)
+            {
+                buf.append('G');
+                buf.appendInt(sink.first);
+                buf.append("/IN");
+                buf.appendInt(sink.second + 1);
+            }
+            else if (-1 - sink.first < opt.numFFs)
+            {
+                const long f = -1 - sink.first;
+                buf.append('F');
+                buf.appendInt(f);
+                buf.append('/');
+                appendPinName(buf, "D", ffLibs[ffLib[f]].bit, sink.second);
+            }
+            else
+            {
+                buf.append("out");
+                buf.appendInt(-1 - opt.numFFs - sink.first);
+            }
+            buf.append('\n');
+        }
+        flush();
+    }
+    // clock domains cover contiguous runs of FFs so each domain is a region of the die
+    std::vector<std::vector<long>> domains(opt.numClkDomains);
+    for (long f = 0; f < opt.numFFs; f++)
+    {
+        const long region = f * opt.numClkDomains / opt.numFFs;
+        const long domain = (uniform(10) == 0) ? uniform(opt.numClkDomains) : region;
+        domains[domain].push_back(f);
+    }
+    for (int d = 0; d < opt.numClkDomains; d++)
+    {
+        buf.append("Net clk");
+        buf.appendInt(d);
+        buf.append(' ');
+        buf.appendInt(domains[d].size() + 1);
+        buf.append("\nPin clk\n");
+        for (long f : domains[d])
+        {
+            buf.append("Pin F");
+            buf.appendInt(f);
+            buf.append("/CLK\n");
+            flush();
+        }
+    }
+
+    buf.append("BinWidth ");
+    buf.appendInt(long(opt.binSlots) * slotW);
+    buf.append("\nBinHeight ");
+    buf.appendInt(long(opt.binSlots) * slotH);
+    buf.append('\n');
+    appendDouble(buf, opt.binMaxUtil, "BinMaxUtil %g\n");
+    for (long y = 0; y + rh <= dieH; y += rh)
+    {
+        buf.append("PlacementRows 0 ");
+        buf.appendInt(y);
+        buf.append(' ');
+        buf.appendInt(sw);
+        buf.append(' ');
+        buf.appendInt(rh);
+        buf.append(' ');
+        buf.appendInt(dieW / sw);
+        buf.append('\n');
+        flush();
+    }
+    appendDouble(buf, opt.displacementDelay, "DisplacementDelay %g\n");
+    for (auto& lib : ffLibs)
+    {
+        buf.append("QpinDelay ");
+        buf.append(lib.name);
+        appendDouble(buf, lib.qDelay, " %g\n");
+    }
+    std::normal_distribution<double> slackDist(opt.slackMean, opt.slackStddev);
+    for (long f = 0; f < opt.numFFs; f++)
+    {
+        const GenLib& lib = ffLibs[ffLib[f]];
+        for (int b = 0; b < lib.bit; b++)
+        {
+            buf.append("TimingSlack F");
+            buf.appendInt(f);
+            buf.append(' ');
+            appendPinName(buf, "D", lib.bit, b);
+            appendDouble(buf, slackDist(rng), " %.4f\n");
+        }
+        flush();
+    }
+    for (auto& lib : ffLibs)
+    {
+        buf.append("GatePower ");
+        buf.append(lib.name);
+        appendDouble(buf, lib.power, " %g\n");
+    }
+    for (auto& lib : gateLibs)
+    {
+        buf.append("GatePower ");
+        buf.append(lib.name);
+        appendDouble(buf, lib.power, " %g\n");
+    }
+    buf.writeTo(out);
+    std::cout << "Generated " << opt.numFFs << " FFs, " << opt.numGates << " gates, " << netId << " nets, die "
+              << dieW << " x " << dieH << " in " << opt.output << std::endl;
+    return 0;
+}